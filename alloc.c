@@ -0,0 +1,367 @@
+/**
+ * Slab, size-class and arena allocators.
+ */
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alloc.h"
+
+/** Every chunk starts with a header linking it to the previous chunk. */
+typedef union chunk_header {
+  void *next;
+  max_align_t align;
+} chunk_header_t;
+
+// Objects, buffers and blocks handed out on this thread, see mem_alloc_count
+static _Thread_local unsigned long mem_allocs = 0;
+
+void slab_init(slab_t *s, size_t obj_size, unsigned int per_chunk) {
+  size_t align = sizeof(max_align_t);
+
+  // objects must be able to hold the free list link
+  if (obj_size < sizeof(void *)) {
+    obj_size = sizeof(void *);
+  }
+  memset(s, 0, sizeof(*s));
+  s->obj_size = (obj_size + align - 1) / align * align;
+  s->per_chunk = per_chunk > 0 ? per_chunk : 1;
+}
+
+void *slab_alloc(slab_t *s) {
+  void *obj = s->free_list;
+
+  mem_allocs++;
+  if (obj) {
+    // pop a recycled object off the free list
+    memcpy(&s->free_list, obj, sizeof(void *));
+  } else {
+    if (s->bump == s->bump_end) {
+      // the newest chunk is used up, grab another one
+      size_t bytes = sizeof(chunk_header_t) + s->obj_size * s->per_chunk;
+      chunk_header_t *chunk = malloc(bytes);
+      if (!chunk) {
+        return NULL;
+      }
+      chunk->next = s->chunks;
+      s->chunks = chunk;
+      s->bump = (char *)(chunk + 1);
+      s->bump_end = s->bump + s->obj_size * s->per_chunk;
+      s->reserved += bytes;
+    }
+    obj = s->bump;
+    s->bump += s->obj_size;
+  }
+  s->live++;
+  return obj;
+}
+
+int slab_reserve(slab_t *s, size_t n) {
+  size_t left = (size_t)(s->bump_end - s->bump) / s->obj_size;
+
+  if (left >= n) {
+    return 0;
+  }
+  // the rest of the newest chunk goes to the free list, to be used first
+  n -= left;
+  while (s->bump != s->bump_end) {
+    memcpy(s->bump, &s->free_list, sizeof(void *));
+    s->free_list = s->bump;
+    s->bump += s->obj_size;
+  }
+
+  size_t count = n > s->per_chunk ? n : s->per_chunk;
+  if (count > (SIZE_MAX - sizeof(chunk_header_t)) / s->obj_size) {
+    return -1;
+  }
+  size_t bytes = sizeof(chunk_header_t) + s->obj_size * count;
+  chunk_header_t *chunk = malloc(bytes);
+  if (!chunk) {
+    return -1;
+  }
+  chunk->next = s->chunks;
+  s->chunks = chunk;
+  s->bump = (char *)(chunk + 1);
+  s->bump_end = s->bump + s->obj_size * count;
+  s->reserved += bytes;
+  return 0;
+}
+
+void slab_free(slab_t *s, void *obj) {
+  assert(s->live > 0);
+
+  memcpy(obj, &s->free_list, sizeof(void *));
+  s->free_list = obj;
+  s->live--;
+}
+
+void slab_destroy(slab_t *s) {
+  chunk_header_t *chunk = s->chunks;
+
+  while (chunk) {
+    chunk_header_t *next = chunk->next;
+    free(chunk);
+    chunk = next;
+  }
+  slab_init(s, s->obj_size, s->per_chunk);
+}
+
+#define MEM_CHUNK_BYTES 16384
+
+// Pool behind mem_alloc and friends; one per thread, so threads never
+// contend for it
+static _Thread_local mem_pool_t mem_default_pool;
+
+/** Index of the smallest class that fits size (size <= MEM_MAX_CLASS). */
+static int mem_class_index(size_t size) {
+  int idx = 0;
+  size_t class_size = MEM_MIN_CLASS;
+
+  while (class_size < size) {
+    class_size *= 2;
+    idx++;
+  }
+  return idx;
+}
+
+static slab_t *mem_class(mem_pool_t *pool, size_t size) {
+  int idx = mem_class_index(size);
+  slab_t *s = &pool->classes[idx];
+
+  if (s->obj_size == 0) {
+    size_t class_size = (size_t)MEM_MIN_CLASS << idx;
+    slab_init(s, class_size, MEM_CHUNK_BYTES / class_size);
+  }
+  return s;
+}
+
+size_t mem_capacity(size_t size) {
+  if (size > MEM_MAX_CLASS) {
+    return size;
+  }
+  return (size_t)MEM_MIN_CLASS << mem_class_index(size);
+}
+
+void *mem_pool_alloc(mem_pool_t *pool, size_t size) {
+  if (size > MEM_MAX_CLASS) {
+    mem_allocs++;
+    void *ptr = malloc(size);
+    if (ptr) {
+      pool->large_reserved += size;
+    }
+    return ptr;
+  }
+  return slab_alloc(mem_class(pool, size));
+}
+
+void mem_pool_free(mem_pool_t *pool, void *ptr, size_t size) {
+  if (!ptr) {
+    return;
+  }
+  if (size > MEM_MAX_CLASS) {
+    pool->large_reserved -= size;
+    free(ptr);
+    return;
+  }
+  slab_free(mem_class(pool, size), ptr);
+}
+
+void *mem_pool_realloc(mem_pool_t *pool, void *ptr, size_t old_size, size_t new_size) {
+  if (!ptr) {
+    return mem_pool_alloc(pool, new_size);
+  }
+  if (mem_capacity(old_size) == mem_capacity(new_size)) {
+    return ptr;
+  }
+  if (old_size > MEM_MAX_CLASS && new_size > MEM_MAX_CLASS) {
+    mem_allocs++;
+    void *grown = realloc(ptr, new_size);
+    if (grown) {
+      pool->large_reserved += new_size - old_size;
+    }
+    return grown;
+  }
+
+  void *moved = mem_pool_alloc(pool, new_size);
+  if (!moved) {
+    return NULL;
+  }
+  memcpy(moved, ptr, old_size < new_size ? old_size : new_size);
+  mem_pool_free(pool, ptr, old_size);
+  return moved;
+}
+
+size_t mem_pool_reserved(const mem_pool_t *pool) {
+  size_t total = pool->large_reserved;
+
+  for (int i = 0; i < MEM_NUM_CLASSES; i++) {
+    total += pool->classes[i].reserved;
+  }
+  return total;
+}
+
+void mem_pool_destroy(mem_pool_t *pool) {
+  for (int i = 0; i < MEM_NUM_CLASSES; i++) {
+    if (pool->classes[i].obj_size != 0) {
+      slab_destroy(&pool->classes[i]);
+    }
+  }
+}
+
+void *mem_alloc(size_t size) {
+  return mem_pool_alloc(&mem_default_pool, size);
+}
+
+void mem_free(void *ptr, size_t size) {
+  mem_pool_free(&mem_default_pool, ptr, size);
+}
+
+void *mem_realloc(void *ptr, size_t old_size, size_t new_size) {
+  return mem_pool_realloc(&mem_default_pool, ptr, old_size, new_size);
+}
+
+size_t mem_reserved(void) {
+  return mem_pool_reserved(&mem_default_pool);
+}
+
+unsigned long mem_alloc_count(void) {
+  return mem_allocs;
+}
+
+struct arena_block {
+  arena_block_t *next;      /* Next (newer) block. */
+  size_t size;              /* Usable bytes after the header. */
+  size_t used;              /* Bytes handed out from this block. */
+  max_align_t data[];
+};
+
+/** Insert a fresh block of at least size bytes after the current one. */
+static arena_block_t *arena_new_block(arena_t *a, size_t size) {
+  if (size < ARENA_BLOCK_SIZE) {
+    size = ARENA_BLOCK_SIZE;
+  }
+  if (size > SIZE_MAX - sizeof(arena_block_t)) {
+    return NULL;
+  }
+  mem_allocs++;
+  arena_block_t *block = malloc(sizeof(arena_block_t) + size);
+  if (!block) {
+    return NULL;
+  }
+  block->size = size;
+  block->used = 0;
+  if (a->cur) {
+    block->next = a->cur->next;
+    a->cur->next = block;
+  } else {
+    block->next = a->first;
+    a->first = block;
+  }
+  a->reserved += sizeof(arena_block_t) + size;
+  return block;
+}
+
+void *arena_alloc(arena_t *a, size_t size) {
+  size_t align = sizeof(max_align_t);
+  // a size this close to SIZE_MAX would round up to 0
+  if (size > SIZE_MAX - align) {
+    return NULL;
+  }
+  size = (size + align - 1) / align * align;
+
+  if (!a->cur) {
+    a->cur = a->first;
+    if (a->cur) {
+      a->cur->used = 0;
+    }
+  }
+  // move on to the next kept block that fits, or make a new one
+  while (!a->cur || a->cur->size - a->cur->used < size) {
+    if (a->cur && a->cur->next && a->cur->next->size >= size) {
+      a->cur = a->cur->next;
+      a->cur->used = 0;
+    } else {
+      arena_block_t *block = arena_new_block(a, size);
+      if (!block) {
+        return NULL;
+      }
+      a->cur = block;
+    }
+  }
+
+  void *ptr = (char *)a->cur->data + a->cur->used;
+  a->cur->used += size;
+  return ptr;
+}
+
+char *arena_strndup(arena_t *a, const char *s, size_t n) {
+  char *copy = arena_alloc(a, n + 1);
+  if (copy) {
+    memcpy(copy, s, n);
+    copy[n] = '\0';
+  }
+  return copy;
+}
+
+arena_mark_t arena_mark(arena_t *a) {
+  arena_mark_t mark = {a->cur, a->cur ? a->cur->used : 0};
+  return mark;
+}
+
+void arena_rewind(arena_t *a, arena_mark_t mark) {
+  a->cur = mark.block;
+  if (a->cur) {
+    a->cur->used = mark.used;
+  }
+}
+
+void arena_reset(arena_t *a) {
+  arena_mark_t start = {NULL, 0};
+  arena_rewind(a, start);
+}
+
+void arena_destroy(arena_t *a) {
+  arena_block_t *block = a->first;
+
+  while (block) {
+    arena_block_t *next = block->next;
+    free(block);
+    block = next;
+  }
+  a->first = a->cur = NULL;
+  a->reserved = 0;
+}
+
+#ifdef MEM_COUNT_ALLOCATIONS
+static _Thread_local unsigned long mem_allocations = 0;
+
+// The linker sends every malloc/calloc/realloc call here (--wrap) and the
+// real functions become __real_*
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size) {
+  mem_allocations++;
+  return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size) {
+  mem_allocations++;
+  return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+  mem_allocations++;
+  return __real_realloc(ptr, size);
+}
+
+unsigned long mem_allocation_count(void) {
+  return mem_allocations;
+}
+#else
+unsigned long mem_allocation_count(void) {
+  return 0;
+}
+#endif
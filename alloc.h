@@ -0,0 +1,136 @@
+#ifndef _ALLOC_H
+#define _ALLOC_H
+
+#include <stddef.h>
+
+/**
+ * Slab allocator for fixed-size objects. Objects are carved out of chunks
+ * that are allocated on demand and never move, so pointers to them stay
+ * valid; freed objects are recycled through a free list.
+ */
+typedef struct slab {
+  size_t obj_size;          /* Size of one object, rounded up for alignment. */
+  unsigned int per_chunk;   /* Objects carved from each chunk. */
+  void *free_list;          /* Freed objects, linked through their first word. */
+  void *chunks;             /* Allocated chunks, linked through their header. */
+  char *bump;               /* Next never-used object in the newest chunk ... */
+  char *bump_end;           /* ... and the end of that chunk. */
+  size_t live;              /* Number of objects currently allocated. */
+  size_t reserved;          /* Bytes obtained from malloc. */
+} slab_t;
+
+/** Initialize an empty slab for objects of the given size. */
+void slab_init(slab_t *s, size_t obj_size, unsigned int per_chunk);
+
+/** Allocate one object, or return NULL if memory is exhausted. */
+void *slab_alloc(slab_t *s);
+
+/** Make sure the next n allocations are served from memory the slab
+ *  already holds, with at most one new chunk (of at least n objects) for
+ *  them all. Returns 0, or -1 if memory is exhausted. */
+int slab_reserve(slab_t *s, size_t n);
+
+/** Return an object to the slab it was allocated from. */
+void slab_free(slab_t *s, void *obj);
+
+/** Release every chunk of the slab, invalidating all its objects. */
+void slab_destroy(slab_t *s);
+
+/**
+ * Size-class allocator for variable-length byte buffers such as file
+ * content and names. Requests up to MEM_MAX_CLASS bytes are rounded up to
+ * a power of two and served from one slab per class; larger requests go
+ * straight to malloc. Callers pass the requested size back to mem_free.
+ *
+ * The classes live in a pool. mem_alloc and friends use a pool of the
+ * calling thread; a filesystem keeps its own (see vfs.h), so its memory
+ * goes with it and is never shared with another.
+ */
+#define MEM_MIN_CLASS 16
+#define MEM_MAX_CLASS 4096
+#define MEM_NUM_CLASSES 9   /* MEM_MIN_CLASS, 2 * MEM_MIN_CLASS, ..., MEM_MAX_CLASS */
+
+typedef struct mem_pool {
+  slab_t classes[MEM_NUM_CLASSES];  /* Set up on first use. */
+  size_t large_reserved;    /* Bytes of buffers above MEM_MAX_CLASS. */
+} mem_pool_t;
+
+/** The number of bytes actually reserved for a request of the given size. */
+size_t mem_capacity(size_t size);
+
+/** Allocate at least size bytes from a pool, or return NULL. */
+void *mem_pool_alloc(mem_pool_t *pool, size_t size);
+
+/** Free a buffer obtained from the pool with the given requested size. */
+void mem_pool_free(mem_pool_t *pool, void *ptr, size_t size);
+
+/** Resize a buffer of the pool from old_size to new_size bytes, keeping
+ *  its content. Stays in place when both sizes fall in the same class. */
+void *mem_pool_realloc(mem_pool_t *pool, void *ptr, size_t old_size, size_t new_size);
+
+/** Total bytes a pool has obtained from malloc. */
+size_t mem_pool_reserved(const mem_pool_t *pool);
+
+/** Release the classes of a pool, invalidating every buffer of up to
+ *  MEM_MAX_CLASS bytes; larger ones must have been freed already. */
+void mem_pool_destroy(mem_pool_t *pool);
+
+/** mem_pool_alloc and friends on the calling thread's pool. */
+void *mem_alloc(size_t size);
+void mem_free(void *ptr, size_t size);
+void *mem_realloc(void *ptr, size_t old_size, size_t new_size);
+size_t mem_reserved(void);
+
+/** Number of objects and buffers the allocators of this file have handed
+ *  out so far on the calling thread: every slab_alloc, every mem_alloc
+ *  and friends that gets new memory, and every arena block (a bump within
+ *  a block is free). Counted in every build. */
+unsigned long mem_alloc_count(void);
+
+/** Number of calls to malloc, calloc and realloc made so far on the
+ *  calling thread. Only counted in builds with MEM_COUNT_ALLOCATIONS defined
+ *  and linked with -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc (see
+ *  the Makefile); 0 otherwise. */
+unsigned long mem_allocation_count(void);
+
+/**
+ * Bump arena for short-lived allocations such as the argv of a single
+ * command. Allocation is a pointer bump; memory is given back all at once
+ * by rewinding to a mark. Blocks are kept for reuse after a rewind, so an
+ * arena that has warmed up serves later requests without calling malloc.
+ */
+typedef struct arena_block arena_block_t;
+
+typedef struct arena {
+  arena_block_t *first;     /* Oldest block. */
+  arena_block_t *cur;       /* Block currently being bumped. */
+  size_t reserved;          /* Bytes obtained from malloc. */
+} arena_t;
+
+/** A position in an arena to rewind to. */
+typedef struct arena_mark {
+  arena_block_t *block;
+  size_t used;
+} arena_mark_t;
+
+#define ARENA_BLOCK_SIZE 4096
+
+/** Allocate size bytes (aligned for any type), or return NULL. */
+void *arena_alloc(arena_t *a, size_t size);
+
+/** Copy n bytes of s into the arena and NUL-terminate the copy. */
+char *arena_strndup(arena_t *a, const char *s, size_t n);
+
+/** The current position of the arena. */
+arena_mark_t arena_mark(arena_t *a);
+
+/** Free everything allocated since the mark was taken. */
+void arena_rewind(arena_t *a, arena_mark_t mark);
+
+/** Free everything allocated from the arena. */
+void arena_reset(arena_t *a);
+
+/** Release all blocks of the arena. */
+void arena_destroy(arena_t *a);
+
+#endif /* ifndef _ALLOC_H */
@@ -0,0 +1,372 @@
+/**
+ * Shell microbenchmarks.
+ *
+ * Links the shell itself and drives process_command the way the front
+ * ends do, covering command dispatch, tokenizer throughput, the VFS at
+ * sizes from 10 to 100k entries, output formatting and session setup. Each result is one
+ * JSON object per line on stdout:
+ *
+ *   {"bench": "vfs/find", "size": 1000, "iterations": 2097152,
+ *    "ns_per_op": 41.2, "allocs_per_op": 0.00}
+ *
+ * allocs_per_op counts malloc/calloc/realloc calls; it is only non-zero
+ * when built with MEM_COUNT_ALLOCATIONS and the --wrap link flags (the
+ * Makefile's bench target does both). Pass a name prefix to run a subset,
+ * e.g. `./bench/shell_bench vfs/`.
+ */
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "alloc.h"
+#include "output.h"
+#include "shell.h"
+#include "tokenize.h"
+#include "vect.h"
+#include "vfs.h"
+
+#define MIN_SECONDS 0.2
+#define TOKENIZE_LINE_SIZE (64 * 1024)
+
+static const char *filter = "";
+static shell_session_t *session;
+static vect_t *args;
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/** Run a shell command line, discarding its output. */
+static int run(const char *line) {
+  char buf[256];
+  snprintf(buf, sizeof(buf), "%s", line);
+  int status = process_command(session, buf, args);
+  out_buf_reset(output_buffer());
+  return status;
+}
+
+typedef void (*bench_fn)(void *ctx, long iterations);
+
+/**
+ * Time fn, doubling the iteration count until a run lasts MIN_SECONDS,
+ * and print the result line. fn must do `iterations` operations.
+ */
+static void bench(const char *name, long size, bench_fn fn, void *ctx) {
+  if (strncmp(name, filter, strlen(filter)) != 0) {
+    return;
+  }
+
+  long iterations = 1;
+  double elapsed;
+  unsigned long allocs;
+  for (;;) {
+    unsigned long allocs_before = mem_allocation_count();
+    double start = now();
+    fn(ctx, iterations);
+    elapsed = now() - start;
+    allocs = mem_allocation_count() - allocs_before;
+    if (elapsed >= MIN_SECONDS || iterations >= (1L << 30)) {
+      break;
+    }
+    iterations *= 2;
+  }
+
+  printf("{\"bench\": \"%s\", \"size\": %ld, \"iterations\": %ld, "
+         "\"ns_per_op\": %.1f, \"allocs_per_op\": %.2f}\n",
+         name, size, iterations, elapsed * 1e9 / iterations, (double)allocs / iterations);
+  fflush(stdout);
+}
+
+/**
+ * Command dispatch
+ */
+
+static void bench_command(void *ctx, long iterations) {
+  for (long i = 0; i < iterations; i++) {
+    run(ctx);
+  }
+}
+
+/** A different line every time, so the parsed-line cache always misses. */
+static void bench_unique_command(void *ctx, long iterations) {
+  static long serial = 0;
+  char line[64];
+  for (long i = 0; i < iterations; i++) {
+    snprintf(line, sizeof(line), "echo unique %ld", serial++);
+    run(line);
+  }
+}
+
+static void bench_dispatch(void) {
+  bench("dispatch/pwd", 0, bench_command, "pwd");
+  bench("dispatch/echo", 0, bench_command, "echo hello \"big world\" again");
+  bench("dispatch/unknown", 0, bench_command, "nosuch --flag");
+  bench("dispatch/pipeline", 0, bench_command, "cat README.md | grep ls | wc -l");
+  bench("dispatch/uncached", 0, bench_unique_command, NULL);
+}
+
+/**
+ * Tokenizer throughput
+ */
+
+static void bench_tokenize_line(void *ctx, long iterations) {
+  static token_span_t spans[TOKENIZE_LINE_SIZE];
+  for (long i = 0; i < iterations; i++) {
+    tokenize_spans(ctx, spans, TOKENIZE_LINE_SIZE);
+  }
+}
+
+static void bench_tokenize(void) {
+  char *line = malloc(TOKENIZE_LINE_SIZE + 1);
+
+  // ordinary command lines: short words, quotes and operators
+  static const char words[] = "ls -l | grep \"some file\" > out; cat x ";
+  for (size_t i = 0; i < TOKENIZE_LINE_SIZE; i++) {
+    line[i] = words[i % (sizeof(words) - 1)];
+  }
+  line[TOKENIZE_LINE_SIZE] = '\0';
+  bench("tokenize/64k_mixed", TOKENIZE_LINE_SIZE, bench_tokenize_line, line);
+
+  // long quoted payloads, as in echo "..." > file
+  for (size_t i = 0; i < TOKENIZE_LINE_SIZE; i++) {
+    line[i] = (i % 4096 == 0) ? '"' : 'a' + i % 26;
+  }
+  bench("tokenize/64k_quoted", TOKENIZE_LINE_SIZE, bench_tokenize_line, line);
+  free(line);
+}
+
+/**
+ * VFS operations at increasing sizes: a directory with `size` files
+ */
+
+typedef struct {
+  long size;
+  char dir[64];
+} vfs_ctx_t;
+
+static void bench_find(void *ctx, long iterations) {
+  vfs_ctx_t *vfs = ctx;
+  char path[128];
+  long found = 0;
+  for (long i = 0; i < iterations; i++) {
+    snprintf(path, sizeof(path), "%s/f%ld", vfs->dir, (i * 7919) % vfs->size);
+    found += find_fs_entry(path) != NULL;
+  }
+  if (found != iterations) {
+    fprintf(stderr, "find_fs_entry missed %ld paths\n", iterations - found);
+  }
+}
+
+static void bench_ls(void *ctx, long iterations) {
+  for (long i = 0; i < iterations; i++) {
+    run("ls");
+  }
+}
+
+/** touch of a file through a relative path with "." and "..", resolved
+ *  from the current directory (the big one) in one pass. */
+static void bench_touch_relative(void *ctx, long iterations) {
+  vfs_ctx_t *vfs = ctx;
+  char line[160];
+  for (long i = 0; i < iterations; i++) {
+    snprintf(line, sizeof(line), "touch ../%s/./f%ld", vfs->dir + strlen("/home/"),
+             (i * 7919) % vfs->size);
+    run(line);
+  }
+}
+
+/** A pattern with a literal prefix in the big directory, matched through
+ *  the sorted index of its children, which stays valid between runs. */
+static void bench_glob_prefix(void *ctx, long iterations) {
+  for (long i = 0; i < iterations; i++) {
+    run("echo f99*");
+  }
+}
+
+/** A pattern without one, matched against every child. */
+static void bench_glob_scan(void *ctx, long iterations) {
+  for (long i = 0; i < iterations; i++) {
+    run("echo *99");
+  }
+}
+
+/** rm of a file in the big directory. Each rm is paired with the
+ *  add_fs_entry creating its file, so the directory keeps its size;
+ *  vfs/add_remove measures that pair without the command. */
+static void bench_rm(void *ctx, long iterations) {
+  vfs_ctx_t *vfs = ctx;
+  char line[128];
+  for (long i = 0; i < iterations; i++) {
+    snprintf(line, sizeof(line), "%s/rm%ld", vfs->dir, i);
+    add_fs_entry(line, false);
+    snprintf(line, sizeof(line), "rm rm%ld", i);
+    run(line);
+  }
+}
+
+static void bench_touch_rm_baseline(void *ctx, long iterations) {
+  vfs_ctx_t *vfs = ctx;
+  char line[128];
+  for (long i = 0; i < iterations; i++) {
+    snprintf(line, sizeof(line), "%s/rm%ld", vfs->dir, i);
+    remove_fs_entry(add_fs_entry(line, false));
+  }
+}
+
+/** mv of the big directory there and back; each move relinks one node
+ *  whatever the directory holds. */
+static void bench_mv(void *ctx, long iterations) {
+  vfs_ctx_t *vfs = ctx;
+  char line[160];
+  for (long i = 0; i < iterations; i++) {
+    snprintf(line, sizeof(line), "mv %s /home/moved", vfs->dir);
+    run(line);
+    snprintf(line, sizeof(line), "mv /home/moved %s", vfs->dir);
+    run(line);
+  }
+}
+
+/** cp -r of the big directory, paired with the rm -r of the copy. */
+static void bench_cp_r(void *ctx, long iterations) {
+  vfs_ctx_t *vfs = ctx;
+  char line[160];
+  for (long i = 0; i < iterations; i++) {
+    snprintf(line, sizeof(line), "cp -r %s /home/copy", vfs->dir);
+    run(line);
+    run("rm -r /home/copy");
+  }
+}
+
+static void bench_vfs(void) {
+  static const long sizes[] = {10, 100, 1000, 10000, 100000};
+
+  for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+    vfs_ctx_t vfs = {sizes[s]};
+    char path[128];
+    snprintf(vfs.dir, sizeof(vfs.dir), "/home/bench%ld", vfs.size);
+    add_fs_entry(vfs.dir, true);
+    for (long i = 0; i < vfs.size; i++) {
+      snprintf(path, sizeof(path), "%s/f%ld", vfs.dir, i);
+      add_fs_entry(path, false);
+    }
+    snprintf(path, sizeof(path), "cd %s", vfs.dir);
+    run(path);
+
+    bench("vfs/find", vfs.size, bench_find, &vfs);
+    bench("vfs/ls", vfs.size, bench_ls, &vfs);
+    bench("vfs/touch_relative", vfs.size, bench_touch_relative, &vfs);
+    bench("vfs/glob_prefix", vfs.size, bench_glob_prefix, &vfs);
+    bench("vfs/glob_scan", vfs.size, bench_glob_scan, &vfs);
+    bench("vfs/add_remove", vfs.size, bench_touch_rm_baseline, &vfs);
+    bench("vfs/rm", vfs.size, bench_rm, &vfs);
+
+    run("cd /home");
+    bench("vfs/mv_dir", vfs.size, bench_mv, &vfs);
+    bench("vfs/cp_r", vfs.size, bench_cp_r, &vfs);
+
+    snprintf(path, sizeof(path), "rm -r %s", vfs.dir);
+    run(path);
+  }
+}
+
+/**
+ * Output formatting
+ */
+
+static void bench_printf(void *ctx, long iterations) {
+  for (long i = 0; i < iterations; i++) {
+    custom_printf("%s  -  guest  guest  %ld  %s\n", "-rw-r--r--", i, "file.txt");
+    if ((i & 1023) == 1023) {
+      out_buf_reset(output_buffer());
+    }
+  }
+  out_buf_reset(output_buffer());
+}
+
+static void bench_write(void *ctx, long iterations) {
+  for (long i = 0; i < iterations; i++) {
+    output_write("a line of plain output text\n", 28);
+    if ((i & 1023) == 1023) {
+      out_buf_reset(output_buffer());
+    }
+  }
+  out_buf_reset(output_buffer());
+}
+
+/** Fill the buffer and write it out the way the native front end does, one
+ *  flush per operation; once warmed up, a flush allocates nothing. */
+static void bench_flush(void *ctx, long iterations) {
+  for (long i = 0; i < iterations; i++) {
+    while (output_buffer()->len < OUT_BUF_FLUSH_BYTES) {
+      output_write("a line of plain output text\n", 28);
+    }
+    out_buf_reset(output_buffer());
+  }
+}
+
+static void bench_output(void) {
+  bench("output/printf", 0, bench_printf, NULL);
+  bench("output/write", 0, bench_write, NULL);
+  bench("output/flush", OUT_BUF_FLUSH_BYTES, bench_flush, NULL);
+
+  // a 1 MB file through cat, whole and cut short by a pipeline
+  size_t size = 1 << 20;
+  char *content = malloc(size);
+  for (size_t i = 0; i < size; i++) {
+    content[i] = (i % 80 == 79) ? '\n' : 'a' + i % 26;
+  }
+  fs_set_content(add_fs_entry("/home/bench.txt", false), content, size);
+  free(content);
+  bench("output/cat_1mb", (long)size, bench_command, "cat bench.txt");
+  bench("output/cat_1mb_head", (long)size, bench_command, "cat bench.txt | head -5");
+  bench("output/cat_1mb_wc", (long)size, bench_command, "cat bench.txt | wc -l");
+
+  // copies share the content instead of copying the megabyte
+  bench("vfs/cp_1mb", (long)size, bench_command, "cp bench.txt copy.txt");
+  run("rm bench.txt copy.txt");
+}
+
+/**
+ * Sessions: a new session on the shared initial image, one command that
+ * changes it, and its teardown
+ */
+
+static void bench_session_new(void *ctx, long iterations) {
+  for (long i = 0; i < iterations; i++) {
+    char line[] = "echo hello >> README.md";
+    shell_session_t *other = shell_session_new();
+    process_command(other, line, args);
+    vect_clear(args);
+    shell_session_delete(other);
+  }
+  shell_session_use(session);
+}
+
+static void bench_sessions(void) {
+  bench("session/new", 0, bench_session_new, NULL);
+}
+
+int main(int argc, char **argv) {
+  if (argc > 1) {
+    filter = argv[1];
+  }
+  session = shell_session_new();
+  shell_session_use(session);   // for the direct vfs.h and output.h calls
+  args = vect_new();
+  run("cd /home");    // initializes the filesystem
+
+  bench_dispatch();
+  bench_tokenize();
+  bench_vfs();
+  bench_output();
+  bench_sessions();
+
+  vect_delete(args);
+  shell_session_delete(session);
+  return 0;
+}
@@ -0,0 +1,144 @@
+/**
+ * Content-addressed blob store, see blob.h.
+ *
+ * Blobs are chained in a hash table keyed on a hash of their bytes. The
+ * table and the statistics are guarded by one mutex; references are
+ * counted atomically, so sharing a blob does not take the lock. A blob
+ * whose count has dropped to zero is dying: lookups no longer hand it out,
+ * and the thread that dropped the last reference unlinks and frees it.
+ */
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "blob.h"
+
+#define BLOB_MIN_BUCKETS 64
+
+static pthread_mutex_t store_lock = PTHREAD_MUTEX_INITIALIZER;
+static blob_t **buckets = NULL;
+static size_t bucket_count = 0;
+static size_t blob_count = 0;
+static size_t blob_bytes = 0;
+
+/** Hash the bytes eight at a time, multiplying and rotating each word in. */
+static uint64_t blob_hash(const char *data, size_t len) {
+    uint64_t hash = 0x9e3779b97f4a7c15u ^ len;
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        uint64_t word;
+        memcpy(&word, data + i, 8);
+        word *= 0xff51afd7ed558ccdu;
+        hash = ((hash ^ word) << 29 | (hash ^ word) >> 35) * 0xc4ceb9fe1a85ec53u;
+    }
+    // data may be NULL when len is 0, and memcpy must not see it then
+    if (i < len) {
+        uint64_t tail = 0;
+        memcpy(&tail, data + i, len - i);
+        hash ^= tail * 0xff51afd7ed558ccdu;
+    }
+    hash ^= hash >> 33;
+    return hash * 0xc4ceb9fe1a85ec53u;
+}
+
+/** Double the table once it holds a blob per bucket. Called locked. */
+static void blob_table_grow(void) {
+    if (blob_count < bucket_count) {
+        return;
+    }
+    size_t count = bucket_count ? bucket_count * 2 : BLOB_MIN_BUCKETS;
+    blob_t **grown = calloc(count, sizeof(blob_t *));
+    if (!grown) {
+        return;         // longer chains, but still correct
+    }
+    for (size_t i = 0; i < bucket_count; i++) {
+        blob_t *blob = buckets[i];
+        while (blob) {
+            blob_t *next = blob->next;
+            blob->next = grown[blob->hash & (count - 1)];
+            grown[blob->hash & (count - 1)] = blob;
+            blob = next;
+        }
+    }
+    free(buckets);
+    buckets = grown;
+    bucket_count = count;
+}
+
+/** Take a reference unless the blob is dying. */
+static int blob_try_ref(blob_t *blob) {
+    unsigned int refs = atomic_load(&blob->refs);
+    while (refs > 0) {
+        if (atomic_compare_exchange_weak(&blob->refs, &refs, refs + 1)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+blob_t *blob_intern(const char *data, size_t len) {
+    uint64_t hash = blob_hash(data, len);
+
+    pthread_mutex_lock(&store_lock);
+    if (bucket_count > 0) {
+        for (blob_t *blob = buckets[hash & (bucket_count - 1)]; blob; blob = blob->next) {
+            if (blob->hash == hash && blob->size == len &&
+                (len == 0 || memcmp(blob->data, data, len) == 0) && blob_try_ref(blob)) {
+                pthread_mutex_unlock(&store_lock);
+                return blob;
+            }
+        }
+    }
+
+    blob_table_grow();
+    blob_t *blob = bucket_count ? malloc(sizeof(blob_t) + len + 1) : NULL;
+    if (!blob) {
+        pthread_mutex_unlock(&store_lock);
+        return NULL;
+    }
+    blob->hash = hash;
+    blob->size = len;
+    atomic_init(&blob->refs, 1);
+    if (len > 0) {
+        memcpy(blob->data, data, len);
+    }
+    blob->data[len] = '\0';
+    blob->next = buckets[hash & (bucket_count - 1)];
+    buckets[hash & (bucket_count - 1)] = blob;
+    blob_count++;
+    blob_bytes += len;
+    pthread_mutex_unlock(&store_lock);
+    return blob;
+}
+
+blob_t *blob_from_data(const char *data) {
+    return (blob_t *)(data - offsetof(blob_t, data));
+}
+
+void blob_ref(blob_t *blob) {
+    atomic_fetch_add(&blob->refs, 1);
+}
+
+void blob_unref(blob_t *blob) {
+    if (atomic_fetch_sub(&blob->refs, 1) != 1) {
+        return;
+    }
+    // Dying: nobody else can reach it any more except through the table
+    pthread_mutex_lock(&store_lock);
+    blob_t **link = &buckets[blob->hash & (bucket_count - 1)];
+    while (*link != blob) {
+        link = &(*link)->next;
+    }
+    *link = blob->next;
+    blob_count--;
+    blob_bytes -= blob->size;
+    pthread_mutex_unlock(&store_lock);
+    free(blob);
+}
+
+void blob_store_stats(size_t *count, size_t *bytes) {
+    pthread_mutex_lock(&store_lock);
+    *count = blob_count;
+    *bytes = blob_bytes;
+    pthread_mutex_unlock(&store_lock);
+}
@@ -0,0 +1,42 @@
+#ifndef _BLOB_H
+#define _BLOB_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Content-addressed store of immutable byte strings ("blobs"), shared by
+ * every filesystem of the process: file content with the same bytes is
+ * kept once, however many entries and sessions hold it. Blobs are
+ * reference counted and freed with their last reference.
+ *
+ * The store is safe to use from any thread.
+ */
+typedef struct blob blob_t;
+struct blob {
+    blob_t *next;                 /* Next blob in the same bucket. */
+    uint64_t hash;
+    size_t size;                  /* Bytes of data, excluding the NUL. */
+    atomic_uint refs;
+    char data[];                  /* NUL-terminated. */
+};
+
+/** The blob holding the given bytes, with a new reference: an existing
+ *  one if the store has it, else a new copy. data may be NULL when len
+ *  is 0. NULL if memory is exhausted. */
+blob_t *blob_intern(const char *data, size_t len);
+
+/** The blob whose data starts at data. */
+blob_t *blob_from_data(const char *data);
+
+/** Add a reference to a blob. */
+void blob_ref(blob_t *blob);
+
+/** Drop a reference, freeing the blob with the last one. */
+void blob_unref(blob_t *blob);
+
+/** Number of blobs in the store and the bytes of data they hold. */
+void blob_store_stats(size_t *count, size_t *bytes);
+
+#endif /* ifndef _BLOB_H */
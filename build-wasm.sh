@@ -4,11 +4,12 @@
 mkdir -p wasm-build
 
 # Compile the C code to WebAssembly
-emcc shell.c vect.c tokenize.c wasm-main.c \
+emcc shell.c vect.c vfs.c blob.c glob.c alloc.c output.c filters.c snapshot.c journal.c stats.c tokenize.c wasm-main.c \
   -o wasm-build/terminal.js \
+  -msimd128 \
   -s WASM=1 \
-  -s EXPORTED_FUNCTIONS='["_main", "_process_wasm_command"]' \
-  -s EXPORTED_RUNTIME_METHODS='["ccall", "cwrap"]' \
+  -s EXPORTED_FUNCTIONS='["_main", "_process_wasm_command", "_get_output_ptr", "_get_output_length", "_process_wasm_batch", "_get_batch_results", "_get_batch_count", "_get_snapshot", "_get_snapshot_length", "_load_snapshot", "_enable_journal", "_get_journal", "_get_journal_length", "_clear_journal", "_should_compact_journal", "_replay_journal", "_get_stats_json", "_malloc", "_free"]' \
+  -s EXPORTED_RUNTIME_METHODS='["ccall", "cwrap", "HEAPU8", "HEAP32"]' \
   -s EXIT_RUNTIME=0 \
   -s ALLOW_MEMORY_GROWTH=1 \
   -s ASSERTIONS=2 \
@@ -0,0 +1,647 @@
+/**
+ * Line-oriented filter builtins (cat, grep, wc, head, tail, sort, uniq) and
+ * the line streams that connect them to the stage before them in a
+ * pipeline.
+ */
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "filters.h"
+
+/**
+ * Line streams
+ */
+
+/** Hand the collected line to the filter with its output going downstream. */
+static void line_stream_deliver(line_stream_t *stream) {
+    stream->line[stream->len] = '\0';
+
+    out_sink_t *previous = output_set_sink(stream->downstream);
+    int result = stream->filter->line(stream->state, stream->line, stream->len);
+    output_set_sink(previous);
+
+    stream->len = 0;
+    if (result == FILTER_DONE || stream->downstream->closed) {
+        stream->sink.closed = true;
+    }
+}
+
+/** Append bytes to the partial line, growing its buffer as needed. */
+static int line_stream_append(line_stream_t *stream, const char *data, size_t len) {
+    if (stream->len + len + 1 > stream->cap) {
+        size_t cap = stream->cap ? stream->cap * 2 : 256;
+        while (cap < stream->len + len + 1) {
+            cap *= 2;
+        }
+        char *line = arena_alloc(stream->arena, cap);
+        if (!line) {
+            return -1;
+        }
+        if (stream->len > 0) {
+            memcpy(line, stream->line, stream->len);
+        }
+        stream->line = line;
+        stream->cap = cap;
+    }
+    memcpy(stream->line + stream->len, data, len);
+    stream->len += len;
+    return 0;
+}
+
+static int line_stream_write(out_sink_t *sink, const char *data, size_t len) {
+    line_stream_t *stream = (line_stream_t *)sink;
+
+    while (len > 0 && !stream->sink.closed) {
+        const char *newline = memchr(data, '\n', len);
+        size_t chunk = newline ? (size_t)(newline - data) + 1 : len;
+        if (line_stream_append(stream, data, chunk) != 0) {
+            stream->sink.closed = true;
+            break;
+        }
+        if (newline) {
+            line_stream_deliver(stream);
+        }
+        data += chunk;
+        len -= chunk;
+    }
+    return stream->sink.closed ? -1 : 0;
+}
+
+void line_stream_init(line_stream_t *stream, const filter_t *filter, void *state,
+                      out_sink_t *downstream, arena_t *arena) {
+    memset(stream, 0, sizeof(*stream));
+    stream->sink.write = line_stream_write;
+    stream->filter = filter;
+    stream->state = state;
+    stream->downstream = downstream;
+    stream->arena = arena;
+}
+
+int line_stream_finish(line_stream_t *stream) {
+    if (stream->len > 0 && !stream->sink.closed) {
+        line_stream_deliver(stream);
+    }
+    stream->sink.closed = true;
+
+    out_sink_t *previous = output_set_sink(stream->downstream);
+    int status = stream->filter->end(stream->state);
+    output_set_sink(previous);
+    return status;
+}
+
+/**
+ * Helpers
+ */
+
+/** Length of a line without its trailing newline. */
+static size_t line_body(const char *line, size_t len) {
+    return len > 0 && line[len - 1] == '\n' ? len - 1 : len;
+}
+
+/** Print a line, adding the newline if it was missing. */
+static void print_line(const char *line, size_t len) {
+    output_write(line, len);
+    if (len == 0 || line[len - 1] != '\n') {
+        output_write("\n", 1);
+    }
+}
+
+/** Parse a line count for head/tail: "-n N", "-nN" or "-N". Returns the
+ *  index of the first operand, or -1. */
+static int parse_count_option(const char *name, int argc, const char **argv, long *count) {
+    int i = 1;
+    for (; i < argc && argv[i][0] == '-' && argv[i][1] != '\0'; i++) {
+        const char *value = NULL;
+        if (strcmp(argv[i], "-n") == 0) {
+            if (++i >= argc) {
+                custom_printf("%s: option requires an argument -- 'n'\n", name);
+                return -1;
+            }
+            value = argv[i];
+        } else if (argv[i][1] == 'n') {
+            value = argv[i] + 2;
+        } else {
+            value = argv[i] + 1;
+        }
+
+        char *end;
+        *count = strtol(value, &end, 10);
+        if (*value == '\0' || *end != '\0' || *count < 0) {
+            custom_printf("%s: invalid number of lines: '%s'\n", name, value);
+            return -1;
+        }
+    }
+    return i;
+}
+
+/**
+ * cat, without operands; with them it is an ordinary builtin
+ */
+
+static int cat_begin(void *state, arena_t *arena, int argc, const char **argv) {
+    return 1;
+}
+
+static int cat_line(void *state, const char *line, size_t len) {
+    output_write(line, len);
+    return FILTER_CONTINUE;
+}
+
+static int cat_end(void *state) {
+    return 0;
+}
+
+const filter_t cat_filter = {0, cat_begin, cat_line, cat_end};
+
+/**
+ * grep [-v] [-i] [-c] [-n] <pattern> [file...]
+ */
+
+typedef struct {
+    const char *pattern;
+    size_t pattern_len;
+    bool invert;
+    bool ignore_case;
+    bool count_only;
+    bool number;
+    long line_number;
+    long matches;
+} grep_state_t;
+
+static int grep_begin(void *state, arena_t *arena, int argc, const char **argv) {
+    grep_state_t *grep = state;
+    int i = 1;
+
+    for (; i < argc && argv[i][0] == '-' && argv[i][1] != '\0'; i++) {
+        for (const char *opt = argv[i] + 1; *opt; opt++) {
+            switch (*opt) {
+            case 'v': grep->invert = true; break;
+            case 'i': grep->ignore_case = true; break;
+            case 'c': grep->count_only = true; break;
+            case 'n': grep->number = true; break;
+            default:
+                custom_printf("grep: invalid option -- '%c'\n", *opt);
+                return -1;
+            }
+        }
+    }
+    if (i >= argc) {
+        custom_printf("grep: missing pattern\n");
+        return -1;
+    }
+    grep->pattern = argv[i];
+    grep->pattern_len = strlen(argv[i]);
+    return i + 1;
+}
+
+/** Does the pattern occur in the first len bytes of line? */
+static bool grep_matches(grep_state_t *grep, const char *line, size_t len) {
+    if (grep->pattern_len > len) {
+        return false;
+    }
+    for (size_t i = 0; i + grep->pattern_len <= len; i++) {
+        size_t j = 0;
+        if (grep->ignore_case) {
+            while (j < grep->pattern_len &&
+                   tolower((unsigned char)line[i + j]) == tolower((unsigned char)grep->pattern[j])) {
+                j++;
+            }
+        } else {
+            while (j < grep->pattern_len && line[i + j] == grep->pattern[j]) {
+                j++;
+            }
+        }
+        if (j == grep->pattern_len) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static int grep_line(void *state, const char *line, size_t len) {
+    grep_state_t *grep = state;
+
+    grep->line_number++;
+    if (grep_matches(grep, line, line_body(line, len)) == grep->invert) {
+        return FILTER_CONTINUE;
+    }
+    grep->matches++;
+    if (!grep->count_only) {
+        if (grep->number) {
+            custom_printf("%ld:", grep->line_number);
+        }
+        print_line(line, len);
+    }
+    return FILTER_CONTINUE;
+}
+
+static int grep_end(void *state) {
+    grep_state_t *grep = state;
+
+    if (grep->count_only) {
+        custom_printf("%ld\n", grep->matches);
+    }
+    return grep->matches > 0 ? 0 : 1;
+}
+
+const filter_t grep_filter = {sizeof(grep_state_t), grep_begin, grep_line, grep_end};
+
+/**
+ * wc [-l] [-w] [-c] [file...]
+ */
+
+typedef struct {
+    bool lines, words, bytes;   // which counts to print; all if none given
+    long line_count;
+    long word_count;
+    long byte_count;
+} wc_state_t;
+
+static int wc_begin(void *state, arena_t *arena, int argc, const char **argv) {
+    wc_state_t *wc = state;
+    int i = 1;
+
+    for (; i < argc && argv[i][0] == '-' && argv[i][1] != '\0'; i++) {
+        for (const char *opt = argv[i] + 1; *opt; opt++) {
+            switch (*opt) {
+            case 'l': wc->lines = true; break;
+            case 'w': wc->words = true; break;
+            case 'c': wc->bytes = true; break;
+            default:
+                custom_printf("wc: invalid option -- '%c'\n", *opt);
+                return -1;
+            }
+        }
+    }
+    if (!wc->lines && !wc->words && !wc->bytes) {
+        wc->lines = wc->words = wc->bytes = true;
+    }
+    return i;
+}
+
+static int wc_line(void *state, const char *line, size_t len) {
+    wc_state_t *wc = state;
+    bool in_word = false;
+
+    if (len > 0 && line[len - 1] == '\n') {
+        wc->line_count++;
+    }
+    wc->byte_count += len;
+    for (size_t i = 0; i < len; i++) {
+        bool space = isspace((unsigned char)line[i]);
+        if (!space && !in_word) {
+            wc->word_count++;
+        }
+        in_word = !space;
+    }
+    return FILTER_CONTINUE;
+}
+
+static int wc_end(void *state) {
+    wc_state_t *wc = state;
+    const char *separator = "";
+
+    if (wc->lines) {
+        custom_printf("%ld", wc->line_count);
+        separator = " ";
+    }
+    if (wc->words) {
+        custom_printf("%s%ld", separator, wc->word_count);
+        separator = " ";
+    }
+    if (wc->bytes) {
+        custom_printf("%s%ld", separator, wc->byte_count);
+    }
+    custom_printf("\n");
+    return 0;
+}
+
+const filter_t wc_filter = {sizeof(wc_state_t), wc_begin, wc_line, wc_end};
+
+/**
+ * head [-n N] [file...]
+ */
+
+typedef struct {
+    long limit;
+    long seen;
+} head_state_t;
+
+static int head_begin(void *state, arena_t *arena, int argc, const char **argv) {
+    head_state_t *head = state;
+    head->limit = 10;
+    return parse_count_option("head", argc, argv, &head->limit);
+}
+
+static int head_line(void *state, const char *line, size_t len) {
+    head_state_t *head = state;
+
+    if (head->seen >= head->limit) {
+        return FILTER_DONE;
+    }
+    head->seen++;
+    print_line(line, len);
+    return head->seen >= head->limit ? FILTER_DONE : FILTER_CONTINUE;
+}
+
+static int head_end(void *state) {
+    return 0;
+}
+
+const filter_t head_filter = {sizeof(head_state_t), head_begin, head_line, head_end};
+
+/**
+ * tail [-n N] [file...]
+ *
+ * Keeps the last N lines in a ring of size-class buffers, so memory is
+ * bounded by N lines rather than the whole input. The ring grows with the
+ * lines seen until it holds N slots, so a large N costs nothing up front.
+ */
+
+typedef struct {
+    char *data;
+    size_t len;
+    size_t cap;
+} tail_line_t;
+
+typedef struct {
+    arena_t *arena;
+    long limit;
+    long count;                 // lines seen so far
+    tail_line_t *ring;
+    long slots;                 // slots in the ring, at most limit
+} tail_state_t;
+
+static int tail_begin(void *state, arena_t *arena, int argc, const char **argv) {
+    tail_state_t *tail = state;
+    tail->arena = arena;
+    tail->limit = 10;
+
+    int first = parse_count_option("tail", argc, argv, &tail->limit);
+    if (first < 0) {
+        return -1;
+    }
+    if ((unsigned long)tail->limit > SIZE_MAX / sizeof(tail_line_t)) {
+        custom_printf("tail: number of lines too large: %ld\n", tail->limit);
+        return -1;
+    }
+    return first;
+}
+
+/** Make room for one more slot while the ring is not yet full. Lines
+ *  fill the slots in order until then, so growing is a copy. */
+static int tail_grow(tail_state_t *tail) {
+    long slots = tail->slots ? tail->slots * 2 : 16;
+    if (slots > tail->limit) {
+        slots = tail->limit;
+    }
+    tail_line_t *ring = arena_alloc(tail->arena, slots * sizeof(tail_line_t));
+    if (!ring) {
+        return -1;
+    }
+    if (tail->slots > 0) {
+        memcpy(ring, tail->ring, tail->slots * sizeof(tail_line_t));
+    }
+    memset(ring + tail->slots, 0, (slots - tail->slots) * sizeof(tail_line_t));
+    tail->ring = ring;
+    tail->slots = slots;
+    return 0;
+}
+
+static int tail_line(void *state, const char *line, size_t len) {
+    tail_state_t *tail = state;
+
+    if (tail->limit == 0) {
+        return FILTER_CONTINUE;
+    }
+    if (tail->count == tail->slots && tail->slots < tail->limit && tail_grow(tail) != 0) {
+        return FILTER_DONE;
+    }
+    tail_line_t *slot = &tail->ring[tail->count % tail->limit];
+    if (len + 1 > slot->cap) {
+        char *data = mem_realloc(slot->data, slot->cap, len + 1);
+        if (!data) {
+            return FILTER_DONE;
+        }
+        slot->data = data;
+        slot->cap = mem_capacity(len + 1);
+    }
+    memcpy(slot->data, line, len);
+    slot->len = len;
+    tail->count++;
+    return FILTER_CONTINUE;
+}
+
+static int tail_end(void *state) {
+    tail_state_t *tail = state;
+    long first = tail->count > tail->limit ? tail->count - tail->limit : 0;
+
+    for (long i = first; i < tail->count; i++) {
+        tail_line_t *slot = &tail->ring[i % tail->limit];
+        print_line(slot->data, slot->len);
+    }
+    for (long i = 0; i < tail->slots; i++) {
+        mem_free(tail->ring[i].data, tail->ring[i].cap);
+    }
+    return 0;
+}
+
+const filter_t tail_filter = {sizeof(tail_state_t), tail_begin, tail_line, tail_end};
+
+/**
+ * sort [-r] [-n] [file...]
+ */
+
+typedef struct {
+    const char *data;
+    size_t len;
+} sort_line_t;
+
+typedef struct {
+    arena_t *arena;
+    bool reverse;
+    bool numeric;
+    sort_line_t *lines;
+    size_t count;
+    size_t cap;
+} sort_state_t;
+
+static int sort_begin(void *state, arena_t *arena, int argc, const char **argv) {
+    sort_state_t *sort = state;
+    int i = 1;
+
+    sort->arena = arena;
+    for (; i < argc && argv[i][0] == '-' && argv[i][1] != '\0'; i++) {
+        for (const char *opt = argv[i] + 1; *opt; opt++) {
+            switch (*opt) {
+            case 'r': sort->reverse = true; break;
+            case 'n': sort->numeric = true; break;
+            default:
+                custom_printf("sort: invalid option -- '%c'\n", *opt);
+                return -1;
+            }
+        }
+    }
+    return i;
+}
+
+static int sort_line(void *state, const char *line, size_t len) {
+    sort_state_t *sort = state;
+
+    if (sort->count == sort->cap) {
+        size_t cap = sort->cap ? sort->cap * 2 : 64;
+        sort_line_t *lines = arena_alloc(sort->arena, cap * sizeof(sort_line_t));
+        if (!lines) {
+            return FILTER_DONE;
+        }
+        if (sort->count > 0) {
+            memcpy(lines, sort->lines, sort->count * sizeof(sort_line_t));
+        }
+        sort->lines = lines;
+        sort->cap = cap;
+    }
+    len = line_body(line, len);
+    char *copy = arena_strndup(sort->arena, line, len);
+    if (!copy) {
+        return FILTER_DONE;
+    }
+    sort->lines[sort->count].data = copy;
+    sort->lines[sort->count].len = len;
+    sort->count++;
+    return FILTER_CONTINUE;
+}
+
+static int sort_compare(const sort_state_t *sort, const sort_line_t *a, const sort_line_t *b) {
+    int result;
+    if (sort->numeric) {
+        double x = strtod(a->data, NULL), y = strtod(b->data, NULL);
+        result = (x > y) - (x < y);
+    } else {
+        size_t n = a->len < b->len ? a->len : b->len;
+        result = memcmp(a->data, b->data, n);
+        if (result == 0) {
+            result = (a->len > b->len) - (a->len < b->len);
+        }
+    }
+    return sort->reverse ? -result : result;
+}
+
+/** Stable bottom-up merge sort of sort->lines using tmp as scratch. */
+static void sort_lines(sort_state_t *sort, sort_line_t *tmp) {
+    sort_line_t *src = sort->lines, *dst = tmp;
+
+    for (size_t width = 1; width < sort->count; width *= 2) {
+        for (size_t lo = 0; lo < sort->count; lo += 2 * width) {
+            size_t mid = lo + width < sort->count ? lo + width : sort->count;
+            size_t hi = lo + 2 * width < sort->count ? lo + 2 * width : sort->count;
+            size_t i = lo, j = mid, k = lo;
+            while (i < mid && j < hi) {
+                dst[k++] = sort_compare(sort, &src[j], &src[i]) < 0 ? src[j++] : src[i++];
+            }
+            while (i < mid) {
+                dst[k++] = src[i++];
+            }
+            while (j < hi) {
+                dst[k++] = src[j++];
+            }
+        }
+        sort_line_t *swap = src;
+        src = dst;
+        dst = swap;
+    }
+    sort->lines = src;
+}
+
+static int sort_end(void *state) {
+    sort_state_t *sort = state;
+
+    if (sort->count > 1) {
+        sort_line_t *tmp = arena_alloc(sort->arena, sort->count * sizeof(sort_line_t));
+        if (!tmp) {
+            custom_printf("sort: out of memory\n");
+            return 1;
+        }
+        sort_lines(sort, tmp);
+    }
+    for (size_t i = 0; i < sort->count && !output_closed(); i++) {
+        output_write(sort->lines[i].data, sort->lines[i].len);
+        output_write("\n", 1);
+    }
+    return 0;
+}
+
+const filter_t sort_filter = {sizeof(sort_state_t), sort_begin, sort_line, sort_end};
+
+/**
+ * uniq [-c] [file...]
+ */
+
+typedef struct {
+    bool count;
+    char *previous;
+    size_t previous_len;
+    size_t previous_cap;
+    long repeats;               // occurrences of previous, 0 before any line
+} uniq_state_t;
+
+static int uniq_begin(void *state, arena_t *arena, int argc, const char **argv) {
+    uniq_state_t *uniq = state;
+    int i = 1;
+
+    for (; i < argc && argv[i][0] == '-' && argv[i][1] != '\0'; i++) {
+        if (strcmp(argv[i], "-c") == 0) {
+            uniq->count = true;
+        } else {
+            custom_printf("uniq: invalid option '%s'\n", argv[i]);
+            return -1;
+        }
+    }
+    return i;
+}
+
+static void uniq_flush(uniq_state_t *uniq) {
+    if (uniq->repeats == 0) {
+        return;
+    }
+    if (uniq->count) {
+        custom_printf("%7ld ", uniq->repeats);
+    }
+    output_write(uniq->previous, uniq->previous_len);
+    output_write("\n", 1);
+}
+
+static int uniq_line(void *state, const char *line, size_t len) {
+    uniq_state_t *uniq = state;
+
+    len = line_body(line, len);
+    if (uniq->repeats > 0 && len == uniq->previous_len && memcmp(line, uniq->previous, len) == 0) {
+        uniq->repeats++;
+        return FILTER_CONTINUE;
+    }
+    uniq_flush(uniq);
+    if (len + 1 > uniq->previous_cap) {
+        char *previous = mem_realloc(uniq->previous, uniq->previous_cap, len + 1);
+        if (!previous) {
+            return FILTER_DONE;
+        }
+        uniq->previous = previous;
+        uniq->previous_cap = mem_capacity(len + 1);
+    }
+    memcpy(uniq->previous, line, len);
+    uniq->previous_len = len;
+    uniq->repeats = 1;
+    return FILTER_CONTINUE;
+}
+
+static int uniq_end(void *state) {
+    uniq_state_t *uniq = state;
+
+    uniq_flush(uniq);
+    mem_free(uniq->previous, uniq->previous_cap);
+    return 0;
+}
+
+const filter_t uniq_filter = {sizeof(uniq_state_t), uniq_begin, uniq_line, uniq_end};
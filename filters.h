@@ -0,0 +1,70 @@
+#ifndef _FILTERS_H
+#define _FILTERS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "alloc.h"
+#include "output.h"
+
+/* Return values of filter_t.line. */
+#define FILTER_CONTINUE 0
+#define FILTER_DONE 1           /* The filter wants no more input. */
+
+/**
+ * A line-oriented builtin that consumes input: cat (without operands),
+ * grep, wc, head, tail, sort and uniq. Input arrives one line at a time
+ * through a line_stream_t, so a pipeline never holds more than the
+ * longest line in flight (unless the filter itself must buffer, like sort
+ * and tail).
+ */
+typedef struct filter {
+    size_t state_size;
+
+    /** Parse options into the zeroed state. Returns the index of the first
+     *  file operand, or -1 after printing a usage error. */
+    int (*begin)(void *state, arena_t *arena, int argc, const char **argv);
+
+    /** Consume one line. line is NUL-terminated and includes its '\n'
+     *  unless it is the unterminated last line. */
+    int (*line)(void *state, const char *line, size_t len);
+
+    /** Flush any buffered output. Returns the filter's exit status. */
+    int (*end)(void *state);
+} filter_t;
+
+extern const filter_t cat_filter;
+extern const filter_t grep_filter;
+extern const filter_t wc_filter;
+extern const filter_t head_filter;
+extern const filter_t tail_filter;
+extern const filter_t sort_filter;
+extern const filter_t uniq_filter;
+
+/**
+ * A sink that splits the bytes written to it into lines and feeds them to
+ * a filter, whose own output goes to downstream. The stream closes as soon
+ * as the filter is done or downstream is closed, which in turn tells the
+ * producer writing into it to stop.
+ */
+typedef struct line_stream {
+    out_sink_t sink;              /* Must be first. */
+    const filter_t *filter;
+    void *state;
+    out_sink_t *downstream;
+    arena_t *arena;               /* Backs the line buffer. */
+    char *line;                   /* The partial line collected so far. */
+    size_t len;
+    size_t cap;
+} line_stream_t;
+
+/** Set up a stream feeding filter (with the given state) that writes to
+ *  downstream. */
+void line_stream_init(line_stream_t *stream, const filter_t *filter, void *state,
+                      out_sink_t *downstream, arena_t *arena);
+
+/** Deliver any unterminated last line, then run the filter's end.
+ *  Returns the filter's exit status. */
+int line_stream_finish(line_stream_t *stream);
+
+#endif /* ifndef _FILTERS_H */
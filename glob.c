@@ -0,0 +1,292 @@
+/**
+ * Shell patterns, see glob.h.
+ *
+ * Matching keeps only the position after the last '*' seen: on a
+ * mismatch that star takes one more character and matching resumes from
+ * there. An earlier star never needs to be retried, since the later one
+ * can take whatever it would have, so there is no backtracking beyond
+ * that one position.
+ *
+ * A pattern is expanded one component at a time. A literal component is
+ * a single lookup; one with pattern characters is matched against the
+ * children of the directory. For a large directory and a component with
+ * a literal prefix, the children are sorted into an index once and only
+ * the run with that prefix is matched. The index is rebuilt when the
+ * directory's version changes, which it does whenever its children do.
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "glob.h"
+
+// Directories with this many children are matched through the index when
+// the component has a literal prefix; smaller ones are scanned, which
+// costs less than sorting them
+#define GLOB_INDEX_MIN 64
+
+struct glob_index {
+    unsigned long ino;            /* Directory indexed, 0 for none. */
+    unsigned long version;        /* Its version when it was indexed. */
+    fs_entry_t **children;        /* Sorted by name. */
+    unsigned int count;
+    unsigned int capacity;
+};
+
+/** The state of one expansion. */
+typedef struct {
+    glob_index_t **index;
+    arena_t *arena;
+    glob_list_t *list;
+} glob_state_t;
+
+bool glob_is_pattern(const char *word, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        if (word[i] == '*' || word[i] == '?' || word[i] == '[') {
+            return true;
+        }
+    }
+    return false;
+}
+
+/** Match c against the set of a "[...]" whose body starts at p. Returns
+ *  1 or 0 and points *next past the ']', or -1 if the set is not closed
+ *  before end. */
+static int glob_set(const char *p, const char *end, unsigned char c, const char **next) {
+    bool negate = p < end && (*p == '!' || *p == '^');
+    if (negate) {
+        p++;
+    }
+    const char *first = p;
+    bool match = false;
+    // A ']' right at the start is a member, not the end
+    while (p < end && (*p != ']' || p == first)) {
+        unsigned char low = *p, high = low;
+        if (p + 2 < end && p[1] == '-' && p[2] != ']') {
+            high = p[2];
+            p += 3;
+        } else {
+            p++;
+        }
+        if (low <= c && c <= high) {
+            match = true;
+        }
+    }
+    if (p >= end) {
+        return -1;
+    }
+    *next = p + 1;
+    return match != negate;
+}
+
+bool glob_match(const char *pattern, size_t len, const char *name) {
+    const char *p = pattern, *end = pattern + len;
+    const char *star = NULL;        // pattern after the last '*'
+    const char *retry = NULL;       // where the name resumes after it
+    while (p < end || *name) {
+        if (p < end && *p == '*') {
+            star = ++p;
+            retry = name;
+            continue;
+        }
+        if (p < end && *name) {
+            const char *next = p + 1;
+            int match = *p == '?' || *p == *name;
+            if (*p == '[' && (match = glob_set(p + 1, end, *name, &next)) < 0) {
+                match = *name == '[';       // an unclosed '[' is itself
+            }
+            if (match) {
+                p = next;
+                name++;
+                continue;
+            }
+        }
+        // Let the last star take one more character, if there is one
+        if (!star || !*retry) {
+            return false;
+        }
+        p = star;
+        name = ++retry;
+    }
+    return true;
+}
+
+int glob_list_add(arena_t *arena, glob_list_t *list, const char *word) {
+    if (list->count == list->capacity) {
+        int capacity = list->capacity ? list->capacity * 2 : 16;
+        const char **words = arena_alloc(arena, capacity * sizeof(char *));
+        if (!words) {
+            return -1;
+        }
+        if (list->count > 0) {
+            memcpy(words, list->words, list->count * sizeof(char *));
+        }
+        list->words = words;
+        list->capacity = capacity;
+    }
+    list->words[list->count++] = word;
+    return 0;
+}
+
+static int glob_compare_entries(const void *a, const void *b) {
+    return strcmp((*(fs_entry_t *const *)a)->name, (*(fs_entry_t *const *)b)->name);
+}
+
+static int glob_compare_words(const void *a, const void *b) {
+    return strcmp(*(const char *const *)a, *(const char *const *)b);
+}
+
+/** The children of a directory sorted by name, from the index, which is
+ *  rebuilt if it is for another directory or an older version. NULL if
+ *  memory is exhausted. */
+static fs_entry_t **glob_sorted(glob_index_t **indexp, fs_entry_t *dir, unsigned int *count) {
+    glob_index_t *index = *indexp;
+    if (!index && !(index = *indexp = calloc(1, sizeof(glob_index_t)))) {
+        return NULL;
+    }
+    if (index->ino != dir->ino || index->version != dir->version) {
+        index->ino = 0;
+        if (dir->child_count > index->capacity) {
+            fs_entry_t **children = realloc(index->children, dir->child_count * sizeof(fs_entry_t *));
+            if (!children) {
+                return NULL;
+            }
+            index->children = children;
+            index->capacity = dir->child_count;
+        }
+        unsigned int n = 0;
+        for (fs_entry_t *child = fs_first_child(dir); child && n < index->capacity;
+             child = fs_next_sibling(child)) {
+            index->children[n++] = child;
+        }
+        qsort(index->children, n, sizeof(fs_entry_t *), glob_compare_entries);
+        index->count = n;
+        index->ino = dir->ino;
+        index->version = dir->version;
+    }
+    *count = index->count;
+    return index->children;
+}
+
+/** The first of the sorted entries whose name does not sort before the
+ *  first len bytes of prefix. */
+static unsigned int glob_lower_bound(fs_entry_t **entries, unsigned int count, const char *prefix,
+                                     size_t len) {
+    unsigned int low = 0, high = count;
+    while (low < high) {
+        unsigned int mid = low + (high - low) / 2;
+        if (strncmp(entries[mid]->name, prefix, len) < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+static int glob_walk(glob_state_t *g, fs_entry_t *dir, const char *prefix, size_t prefix_len,
+                     const char *rest);
+
+/** Go on from entry, reached as the component name of a pattern, with
+ *  the components from rest on; if there are none it is a result (a
+ *  directory only, with the slash, if the pattern ends in one). Returns 0
+ *  or -1 if memory is exhausted. */
+static int glob_take(glob_state_t *g, fs_entry_t *entry, const char *prefix, size_t prefix_len,
+                     const char *name, size_t len, const char *rest) {
+    const char *next = rest;
+    while (*next == '/') {
+        next++;
+    }
+    bool slash = next != rest;
+    if (slash && !entry->is_dir) {
+        return 0;
+    }
+
+    size_t path_len = prefix_len + len + slash;
+    char *path = arena_alloc(g->arena, path_len + 1);
+    if (!path) {
+        return -1;
+    }
+    memcpy(path, prefix, prefix_len);
+    memcpy(path + prefix_len, name, len);
+    if (slash) {
+        path[path_len - 1] = '/';
+    }
+    path[path_len] = '\0';
+    if (!*next) {
+        return glob_list_add(g->arena, g->list, path);
+    }
+    return glob_walk(g, entry, path, path_len, next);
+}
+
+/** Expand the components of a pattern from rest on, below directory dir
+ *  reached as prefix ("" or ending in '/'). Returns 0 or -1 if memory is
+ *  exhausted. */
+static int glob_walk(glob_state_t *g, fs_entry_t *dir, const char *prefix, size_t prefix_len,
+                     const char *rest) {
+    size_t len = strcspn(rest, "/");
+    const char *after = rest + len;
+
+    if (!glob_is_pattern(rest, len)) {
+        // A literal component, "." and ".." included, is one step
+        char *name = arena_strndup(g->arena, rest, len);
+        if (!name) {
+            return -1;
+        }
+        fs_entry_t *entry = fs_resolve(dir, name);
+        return entry ? glob_take(g, entry, prefix, prefix_len, rest, len, after) : 0;
+    }
+
+    bool hidden = rest[0] == '.';
+    size_t literal = 0;
+    while (literal < len && !glob_is_pattern(rest + literal, 1)) {
+        literal++;
+    }
+    if (literal > 0 && dir->child_count >= GLOB_INDEX_MIN) {
+        unsigned int count;
+        fs_entry_t **sorted = glob_sorted(g->index, dir, &count);
+        if (sorted) {
+            // Only the run of names starting with the literal prefix
+            for (unsigned int i = glob_lower_bound(sorted, count, rest, literal);
+                 i < count && strncmp(sorted[i]->name, rest, literal) == 0; i++) {
+                const char *name = sorted[i]->name;
+                if (glob_match(rest, len, name) &&
+                    glob_take(g, sorted[i], prefix, prefix_len, name, strlen(name), after) != 0) {
+                    return -1;
+                }
+            }
+            return 0;
+        }
+    }
+    for (fs_entry_t *child = fs_first_child(dir); child; child = fs_next_sibling(child)) {
+        const char *name = child->name;
+        if ((name[0] != '.' || hidden) && glob_match(rest, len, name) &&
+            glob_take(g, child, prefix, prefix_len, name, strlen(name), after) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int glob_expand(glob_index_t **index, arena_t *arena, fs_entry_t *cwd, const char *pattern,
+                glob_list_t *list) {
+    glob_state_t g = {index, arena, list};
+    int start = list->count;
+    fs_entry_t *dir = pattern[0] == '/' ? fs_root() : cwd;
+    if (!dir) {
+        return 0;
+    }
+
+    size_t prefix_len = strspn(pattern, "/");
+    if (glob_walk(&g, dir, pattern, prefix_len, pattern + prefix_len) != 0) {
+        return -1;
+    }
+    qsort(list->words + start, list->count - start, sizeof(char *), glob_compare_words);
+    return list->count - start;
+}
+
+void glob_index_free(glob_index_t *index) {
+    if (index) {
+        free(index->children);
+        free(index);
+    }
+}
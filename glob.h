@@ -0,0 +1,53 @@
+#ifndef _GLOB_H
+#define _GLOB_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "alloc.h"
+#include "vfs.h"
+
+/**
+ * Shell patterns: '*' matches any run of characters, '?' any one, and
+ * "[...]" one of a set (ranges like "a-z", negated with '!' or '^'). A
+ * '[' without its ']' is an ordinary character. Names starting with '.'
+ * are matched only by a pattern that starts with '.' too.
+ */
+
+/** Does a word hold a pattern character? */
+bool glob_is_pattern(const char *word, size_t len);
+
+/** Does a name match the first len bytes of a pattern? Takes time
+ *  proportional to the product of the two lengths at worst, whatever the
+ *  stars. */
+bool glob_match(const char *pattern, size_t len, const char *name);
+
+/** Words collected in an arena, growing geometrically. */
+typedef struct {
+    const char **words;
+    int count;
+    int capacity;
+} glob_list_t;
+
+/** Append a word. Returns 0, or -1 if memory is exhausted. */
+int glob_list_add(arena_t *arena, glob_list_t *list, const char *word);
+
+/** Sorted children of the directory last matched with a literal prefix,
+ *  kept until the directory changes. */
+typedef struct glob_index glob_index_t;
+
+/**
+ * Append the paths matching a pattern, absolute or relative to directory
+ * cwd, to a list in sorted order, allocated from the arena. Each
+ * component is matched against the children of the directories matched
+ * so far only; in a large directory, one with a literal prefix ("f1*")
+ * only against the names with that prefix, through *index (created on
+ * first use). Returns the number of paths, or -1 if memory is exhausted.
+ */
+int glob_expand(glob_index_t **index, arena_t *arena, fs_entry_t *cwd, const char *pattern,
+                glob_list_t *list);
+
+/** Free an index (NULL is fine). */
+void glob_index_free(glob_index_t *index);
+
+#endif /* ifndef _GLOB_H */
@@ -0,0 +1,274 @@
+/**
+ * Mutation journal of the virtual filesystem, see journal.h.
+ */
+#include <assert.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "journal.h"
+#include "output.h"
+
+// The journal of the calling thread, see journal_use
+static _Thread_local journal_t *bound_journal = NULL;
+
+/** The calling thread's journal, which must have been selected. */
+static journal_t *current_journal(void) {
+    assert(bound_journal && "no journal selected, see journal_use");
+    return bound_journal;
+}
+
+/** Append value as an unsigned LEB128 varint. */
+static size_t put_varint(unsigned char *out, uint64_t value) {
+    size_t n = 0;
+    do {
+        unsigned char byte = value & 0x7f;
+        value >>= 7;
+        out[n++] = byte | (value ? 0x80 : 0);
+    } while (value);
+    return n;
+}
+
+/** Read a varint at *pos, advancing it. Returns -1 past the end. */
+static int get_varint(const unsigned char *data, size_t len, size_t *pos, uint64_t *value) {
+    *value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (*pos >= len) {
+            return -1;
+        }
+        unsigned char byte = data[(*pos)++];
+        *value |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return 0;
+        }
+    }
+    return -1;
+}
+
+void journal_destroy(journal_t *j) {
+    if (bound_journal == j) {
+        bound_journal = NULL;
+    }
+    free(j->pending.data);
+    memset(j, 0, sizeof(*j));
+}
+
+journal_t *journal_use(journal_t *j) {
+    journal_t *previous = bound_journal;
+    bound_journal = j;
+    return previous;
+}
+
+void journal_enable(void) {
+    journal_t *journal = current_journal();
+    journal->enabled = true;
+}
+
+bool journal_recording(void) {
+    journal_t *journal = current_journal();
+    return journal->enabled && !journal->suspended;
+}
+
+void journal_record(journal_op_t op, const fs_entry_t *entry, unsigned int flags,
+                    const char *data, size_t len) {
+    journal_t *journal = current_journal();
+    if (!journal_recording()) {
+        return;
+    }
+
+    // Entries keep only their own name, so the path is put together here
+    char small_path[256];
+    size_t path_len = fs_entry_path(entry, small_path, sizeof(small_path));
+    char *path = path_len < sizeof(small_path) ? small_path : malloc(path_len + 1);
+    if (!path) {
+        journal->lost = true;
+        return;
+    }
+    if (path != small_path) {
+        fs_entry_path(entry, path, path_len + 1);
+    }
+
+    int64_t time = op == JOURNAL_CREATE || op == JOURNAL_COPY ? entry->created : entry->modified;
+    unsigned char header[2 + 3 * 10];
+    size_t n = 0;
+    header[n++] = (unsigned char)op;
+    header[n++] = (unsigned char)flags;
+    n += put_varint(header + n, (uint64_t)time);
+    n += put_varint(header + n, path_len);
+    n += put_varint(header + n, len);
+
+    // A record goes in whole or not at all, so the ones after it still
+    // parse; a journal that cannot grow drops it and says so (journal_lost)
+    out_buf_t *b = &journal->pending;
+    size_t start = b->len;
+    if (out_buf_write(b, (const char *)header, n) >= 0 &&
+        out_buf_write(b, path, path_len) >= 0 &&
+        (len == 0 || out_buf_write(b, data, len) >= 0)) {
+        journal->since_base += n + path_len + len;
+    } else {
+        b->len = start;
+        if (b->data) {
+            b->data[start] = '\0';
+        }
+        journal->lost = true;
+    }
+    if (path != small_path) {
+        free(path);
+    }
+}
+
+const char *journal_data(void) {
+    journal_t *journal = current_journal();
+    return journal->pending.data ? journal->pending.data : "";
+}
+
+size_t journal_length(void) {
+    journal_t *journal = current_journal();
+    return journal->pending.len;
+}
+
+void journal_clear(void) {
+    journal_t *journal = current_journal();
+    out_buf_reset(&journal->pending);
+}
+
+void journal_reset(void) {
+    journal_t *journal = current_journal();
+    journal_clear();
+    journal->since_base = 0;
+    journal->lost = false;
+}
+
+void journal_mark_lost(void) {
+    journal_t *journal = current_journal();
+    if (journal_recording()) {
+        journal->lost = true;
+    }
+}
+
+bool journal_lost(void) {
+    journal_t *journal = current_journal();
+    return journal->lost;
+}
+
+bool journal_wants_compaction(void) {
+    journal_t *journal = current_journal();
+    return journal->since_base >= JOURNAL_COMPACT_BYTES;
+}
+
+void journal_suspend(void) {
+    journal_t *journal = current_journal();
+    journal->suspended++;
+}
+
+void journal_resume(void) {
+    journal_t *journal = current_journal();
+    journal->suspended--;
+}
+
+/** Move or copy the entry at the path in data (len bytes) to path. */
+static int journal_apply_transfer(unsigned int op, int64_t time, const char *path,
+                                  const char *data, size_t len) {
+    char *from = malloc(len + 1);
+    if (!from) {
+        errno = ENOMEM;
+        return -1;
+    }
+    memcpy(from, data, len);
+    from[len] = '\0';
+    fs_entry_t *entry = find_fs_entry(from);
+    free(from);
+
+    const char *name;
+    size_t name_len;
+    fs_entry_t *dir = fs_find_parent(path, &name, &name_len);
+    if (!entry || !dir || name_len == 0) {
+        errno = ENOENT;
+        return -1;
+    }
+    if (op == JOURNAL_RENAME) {
+        return fs_rename(entry, dir, name, name_len);
+    }
+    return fs_copy_tree(entry, dir, name, name_len, (time_t)time) ? 0 : -1;
+}
+
+/** Apply one decoded record. */
+static int journal_apply(unsigned int op, unsigned int flags, int64_t time,
+                         const char *path, const char *data, size_t len) {
+    if (op == JOURNAL_RENAME || op == JOURNAL_COPY) {
+        return journal_apply_transfer(op, time, path, data, len);
+    }
+    if (op == JOURNAL_CREATE) {
+        fs_entry_t *entry = add_fs_entry(path, flags & JOURNAL_DIR);
+        if (!entry) {
+            return -1;
+        }
+        entry->created = entry->modified = (time_t)time;
+        return 0;
+    }
+
+    fs_entry_t *entry = find_fs_entry(path);
+    if (!entry) {
+        errno = ENOENT;
+        return -1;
+    }
+    switch (op) {
+    case JOURNAL_REMOVE:
+        return flags & JOURNAL_RECURSIVE ? remove_fs_tree(entry) : remove_fs_entry(entry);
+    case JOURNAL_TOUCH:
+        fs_touch(entry, (time_t)time);
+        return 0;
+    case JOURNAL_WRITE:
+        return fs_set_content(entry, data, len);
+    case JOURNAL_APPEND:
+        return fs_append_content(entry, data, len);
+    default:
+        errno = EINVAL;
+        return -1;
+    }
+}
+
+int journal_replay(const char *data, size_t len) {
+    const unsigned char *bytes = (const unsigned char *)data;
+    size_t pos = 0;
+    char small_path[256];
+    int result = 0;
+
+    journal_suspend();
+    while (pos < len && result == 0) {
+        uint64_t time, path_len, data_len;
+        if (len - pos < 2) {
+            errno = EINVAL;
+            result = -1;
+            break;
+        }
+        unsigned int op = bytes[pos], flags = bytes[pos + 1];
+        pos += 2;
+        if (get_varint(bytes, len, &pos, &time) != 0 ||
+            get_varint(bytes, len, &pos, &path_len) != 0 ||
+            get_varint(bytes, len, &pos, &data_len) != 0 ||
+            path_len == 0 || path_len > len - pos || data_len > len - pos - path_len) {
+            errno = EINVAL;
+            result = -1;
+            break;
+        }
+
+        // Paths are not NUL-terminated in the journal
+        char *path = path_len < sizeof(small_path) ? small_path : malloc(path_len + 1);
+        if (!path) {
+            errno = ENOMEM;
+            result = -1;
+            break;
+        }
+        memcpy(path, data + pos, path_len);
+        path[path_len] = '\0';
+        result = journal_apply(op, flags, (int64_t)time, path, data + pos + path_len, data_len);
+        if (path != small_path) {
+            free(path);
+        }
+        pos += path_len + data_len;
+    }
+    journal_resume();
+    return result;
+}
@@ -0,0 +1,109 @@
+#ifndef _JOURNAL_H
+#define _JOURNAL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "output.h"
+#include "vfs.h"
+
+/**
+ * Append-only journal of filesystem mutations, for incremental
+ * persistence: a front end stores a base snapshot (see snapshot.h) once,
+ * then after each command saves only the records appended since, and on
+ * startup loads the base and replays the records on top of it.
+ *
+ * Every write path of the vfs records itself here, so the cost of
+ * persisting a command is proportional to what it changed. Removing a
+ * whole tree is a single record.
+ *
+ * Record: op (1 byte), flags (1 byte), then as LEB128 varints the time,
+ * the path length and the data length, then the path and data bytes.
+ */
+typedef enum {
+    JOURNAL_CREATE = 1,     /* time = created, flags = JOURNAL_DIR */
+    JOURNAL_REMOVE,         /* flags = JOURNAL_RECURSIVE */
+    JOURNAL_TOUCH,          /* time = modified */
+    JOURNAL_WRITE,          /* data replaces the content */
+    JOURNAL_APPEND,         /* data is appended to the content */
+    JOURNAL_RENAME,         /* data is the path the entry was moved from */
+    JOURNAL_COPY,           /* data is the path of the tree copied, time = created */
+} journal_op_t;
+
+#define JOURNAL_DIR 0x1
+#define JOURNAL_RECURSIVE 0x2
+
+/* Bytes of journal since the base after which compaction is suggested. */
+#define JOURNAL_COMPACT_BYTES (1024 * 1024)
+
+/**
+ * The journal of one filesystem. Each thread records into one at a time,
+ * selected with journal_use, normally along with the filesystem (see
+ * vfs_use); the functions below act on it, and calling them with none
+ * selected is a bug, caught by an assert. A zeroed journal_t is empty and
+ * not recording.
+ */
+typedef struct journal {
+    out_buf_t pending;          /* Records not yet taken by the front end. */
+    size_t since_base;          /* Bytes recorded since the last reset. */
+    bool enabled;
+    bool lost;                  /* A record was dropped since the last reset. */
+    int suspended;
+} journal_t;
+
+/** Free the records of a journal and empty it. If it is the calling
+ *  thread's, the thread is left without one. */
+void journal_destroy(journal_t *j);
+
+/** Make j the calling thread's journal (NULL for none) and return the
+ *  previous one. */
+journal_t *journal_use(journal_t *j);
+
+/** Start recording. The journal is off until a front end that stores it
+ *  turns it on, so a session nobody persists does not accumulate it. */
+void journal_enable(void);
+
+/** True if recording is on and not suspended. */
+bool journal_recording(void);
+
+/** Append a record for entry (by path) if recording is on and not
+ *  suspended. A record that cannot be stored is dropped whole and the
+ *  journal marked lost. */
+void journal_record(journal_op_t op, const fs_entry_t *entry, unsigned int flags,
+                    const char *data, size_t len);
+
+/** Records appended since the last journal_clear, as one byte region. */
+const char *journal_data(void);
+size_t journal_length(void);
+
+/** Drop the pending records, once the front end has stored them. */
+void journal_clear(void);
+
+/** Start over from a new base: drop the pending records, the count of
+ *  bytes since the base and the lost mark. Called when a snapshot is
+ *  taken or loaded. */
+void journal_reset(void);
+
+/** Note that a change is going unrecorded (e.g. its record could not be
+ *  put together), if recording is on and not suspended. */
+void journal_mark_lost(void);
+
+/** True once a change has gone unrecorded since the base. The records no
+ *  longer add up to the filesystem, so the front end must store a fresh
+ *  snapshot instead of them. */
+bool journal_lost(void);
+
+/** True once the journal since the base has grown past
+ *  JOURNAL_COMPACT_BYTES, so storing a fresh snapshot instead pays off. */
+bool journal_wants_compaction(void);
+
+/** Stop or resume recording (nestable), e.g. while loading or replaying. */
+void journal_suspend(void);
+void journal_resume(void);
+
+/** Apply records to the filesystem without recording them again.
+ *  Returns 0, or -1 with errno set at the first record that is malformed
+ *  (EINVAL) or fails to apply. */
+int journal_replay(const char *data, size_t len);
+
+#endif /* ifndef _JOURNAL_H */
@@ -0,0 +1,302 @@
+#include "vect.h"
+#include "output.h"
+#include "shell.h"
+#include "journal.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * Native front end: runs the commands of a script from stdin, or from the
+ * argument of -c, one line at a time.
+ *
+ *   ./shell < script.sh
+ *   ./shell -c 'mkdir d; touch d/f; ls d'
+ *   ./shell --load before.img --save after.img < script.sh
+ *   ./shell --load base.img --replay changes --journal changes < script.sh
+ *
+ * --load starts from a filesystem image saved on the host and --replay
+ * applies journal records (see journal.h) on top of it; --journal appends
+ * the records of the changes the commands made to a host file, and
+ * --save writes an image when they are done. The commands themselves only
+ * ever see the virtual filesystem.
+ *
+ * Reading stdin, it greets, prompts before every line and says goodbye
+ * like an interactive shell. Output is collected in the shell's output
+ * buffer and written out in large blocks; only a prompt on a terminal is
+ * flushed right away. The exit status is that of the last command.
+ */
+
+#define READ_CHUNK (64 * 1024)
+
+/** Write all of data to a file descriptor. Returns 0, or -1 with errno
+ *  set. */
+static int write_all(int fd, const char* data, size_t len) {
+    size_t written = 0;
+    while (written < len) {
+        ssize_t n = write(fd, data + written, len - written);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        written += n;
+    }
+    return 0;
+}
+
+/** Write out and empty the output buffer. */
+static void flush_output(void) {
+    out_buf_t* out = output_buffer();
+    write_all(STDOUT_FILENO, out->data, out->len);     // nowhere to write; drop the output
+    out_buf_reset(out);
+}
+
+/**
+ * Reads lines of any length from a file descriptor through one buffer
+ * that is refilled a chunk at a time and grows only for longer lines.
+ */
+typedef struct {
+    int fd;
+    char* buf;
+    size_t cap;
+    size_t start;       // first byte not yet returned
+    size_t scanned;     // bytes from start known to hold no newline
+    size_t end;         // end of the bytes read
+    bool eof;
+} line_reader_t;
+
+/**
+ * Return the next line without its newline (or "\r\n"), NUL-terminated
+ * in place, or NULL at the end of input. The line stays valid until the
+ * next call.
+ */
+static char* read_line(line_reader_t* r) {
+    for (;;) {
+        size_t unscanned = r->end - r->start - r->scanned;
+        char* newline = unscanned ? memchr(r->buf + r->start + r->scanned, '\n', unscanned) : NULL;
+        if (newline || (r->eof && r->start < r->end)) {
+            char* line = r->buf + r->start;
+            size_t len = newline ? (size_t)(newline - line) : r->end - r->start;
+            r->start += newline ? len + 1 : len;
+            r->scanned = 0;
+            if (len > 0 && line[len - 1] == '\r') {
+                len--;
+            }
+            line[len] = '\0';       // the buffer always has room past end
+            return line;
+        }
+        if (r->eof) {
+            return NULL;
+        }
+
+        // Make room for another chunk: move the partial line to the front,
+        // and grow the buffer only if that line already fills most of it
+        r->scanned = r->end - r->start;
+        if (r->start > 0) {
+            memmove(r->buf, r->buf + r->start, r->end - r->start);
+            r->end -= r->start;
+            r->start = 0;
+        }
+        if (r->cap - r->end < READ_CHUNK + 1) {
+            size_t cap = r->cap ? r->cap * 2 : 2 * READ_CHUNK;
+            char* buf = realloc(r->buf, cap);
+            if (!buf) {
+                fprintf(stderr, "shell: out of memory\n");
+                r->eof = true;
+                continue;
+            }
+            r->buf = buf;
+            r->cap = cap;
+        }
+
+        ssize_t n = read(r->fd, r->buf + r->end, r->cap - r->end - 1);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            r->eof = true;
+        } else {
+            r->end += n;
+        }
+    }
+}
+
+/** Run one line. Returns false once the shell should exit. */
+static bool run_line(shell_session_t* session, char* line, vect_t* args, int* status) {
+    int result = process_command(session, line, args);
+    vect_clear(args);
+    // Written out well before out_buf_reset would free it, so the buffer
+    // is reused between writes
+    if (output_buffer()->len >= OUT_BUF_FLUSH_BYTES) {
+        flush_output();
+    }
+    if (result == SHELL_STATUS_EXIT) {
+        return false;
+    }
+    *status = result;
+    return true;
+}
+
+/** Run the lines of a -c argument, with no prompts. */
+static int run_string(shell_session_t* session, char* script, vect_t* args) {
+    int status = SHELL_STATUS_OK;
+    char* line = script;
+    while (*line) {
+        char* newline = strchr(line, '\n');
+        if (newline) {
+            *newline = '\0';
+        }
+        if (!run_line(session, line, args, &status) || !newline) {
+            break;
+        }
+        line = newline + 1;
+    }
+    return status;
+}
+
+/** Run the lines of stdin, prompting for each. */
+static int run_stdin(shell_session_t* session, vect_t* args) {
+    line_reader_t reader = {STDIN_FILENO};
+    bool interactive = isatty(STDIN_FILENO);
+    int status = SHELL_STATUS_OK;
+
+    custom_printf("Welcome to mini-shell.\n");
+    for (;;) {
+        custom_printf("shell $ ");
+        if (interactive) {
+            flush_output();
+        }
+        char* line = read_line(&reader);
+        if (!line) {
+            custom_printf("\n");
+            break;
+        }
+        if (!run_line(session, line, args, &status)) {
+            break;
+        }
+    }
+    custom_printf("Bye bye.\n");
+    free(reader.buf);
+    return status;
+}
+
+/** Apply the journal records in a host file to the session. Returns 0,
+ *  or -1 with errno set. */
+static int replay_file(shell_session_t* session, const char* path) {
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        int saved_errno = errno;
+        if (fd >= 0) {
+            close(fd);
+        }
+        errno = saved_errno;
+        return -1;
+    }
+    char* data = malloc(st.st_size > 0 ? st.st_size : 1);
+    size_t len = 0;
+    while (data && len < (size_t)st.st_size) {
+        ssize_t n = read(fd, data + len, st.st_size - len);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        len += n;
+    }
+    close(fd);
+    if (!data) {
+        errno = ENOMEM;
+        return -1;
+    }
+    int result = shell_replay_journal(session, data, len);
+    free(data);
+    return result;
+}
+
+/** Append the records journaled so far to a host file. Returns 0, or -1
+ *  with errno set; ENOMEM if some change could not be journaled, in which
+ *  case nothing is appended. */
+static int append_journal(const char* path) {
+    if (journal_lost()) {
+        errno = ENOMEM;
+        return -1;
+    }
+    int fd = open(path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) {
+        return -1;
+    }
+    int result = write_all(fd, journal_data(), journal_length());
+    int saved_errno = errno;
+    if (close(fd) != 0 && result == 0) {
+        return -1;
+    }
+    errno = saved_errno;
+    return result;
+}
+
+static void usage(const char* name) {
+    fprintf(stderr, "Usage: %s [--load image] [--replay journal] [--journal journal] "
+            "[--save image] [-c command]\n", name);
+}
+
+int main(int argc, char** argv) {
+    char* load_path = NULL;
+    char* replay_path = NULL;
+    char* journal_path = NULL;
+    char* save_path = NULL;
+    char* command = NULL;
+    for (int i = 1; i < argc; i++) {
+        char** value = strcmp(argv[i], "--load") == 0 ? &load_path
+            : strcmp(argv[i], "--replay") == 0 ? &replay_path
+            : strcmp(argv[i], "--journal") == 0 ? &journal_path
+            : strcmp(argv[i], "--save") == 0 ? &save_path
+            : strcmp(argv[i], "-c") == 0 ? &command
+            : NULL;
+        if (!value || ++i >= argc) {
+            usage(argv[0]);
+            return 2;
+        }
+        *value = argv[i];
+    }
+
+    // The one session stays current, so output_buffer() is its output
+    shell_session_t* session = shell_session_new();
+    vect_t* args = vect_new();
+    if (!session || !args) {
+        fprintf(stderr, "shell: out of memory\n");
+        return 1;
+    }
+    shell_session_use(session);
+    int status = 1;
+    if (load_path && shell_load_file(session, load_path) != 0) {
+        fprintf(stderr, "shell: %s: %s\n", load_path, strerror(errno));
+    } else if (replay_path && replay_file(session, replay_path) != 0) {
+        fprintf(stderr, "shell: %s: %s\n", replay_path, strerror(errno));
+    } else {
+        if (journal_path) {
+            journal_enable();
+        }
+        status = command ? run_string(session, command, args) : run_stdin(session, args);
+        flush_output();
+        if (journal_path && append_journal(journal_path) != 0) {
+            fprintf(stderr, "shell: %s: %s\n", journal_path, strerror(errno));
+            status = 1;
+        }
+        if (save_path && shell_save_file(session, save_path) != 0) {
+            fprintf(stderr, "shell: %s: %s\n", save_path, strerror(errno));
+            status = 1;
+        }
+    }
+    vect_delete(args);
+    shell_session_delete(session);
+    return status;
+}
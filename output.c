@@ -0,0 +1,193 @@
+/**
+ * Output sink for shell commands.
+ */
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "output.h"
+
+#define OUT_BUF_INITIAL_CAPACITY 4096
+#define OUT_FORMAT_STACK_BYTES 1024
+
+static int buffer_sink_write(out_sink_t *sink, const char *data, size_t len) {
+    output_t *o = (output_t *)sink;
+    if (out_buf_write(&o->buffer, data, len) < 0) {
+        return -1;
+    }
+    o->written += len;
+    return 0;
+}
+
+// The output the calling thread prints into, see output_use
+static _Thread_local output_t *bound_output = NULL;
+
+/** The calling thread's output, which must have been selected. */
+static output_t *current_output(void) {
+    assert(bound_output && "no output selected, see output_use");
+    return bound_output;
+}
+
+/** Make room for at least extra more bytes plus the terminating NUL. */
+static int out_buf_reserve(out_buf_t *b, size_t extra) {
+    size_t needed = b->len + extra + 1;
+
+    if (needed <= b->cap) {
+        return 0;
+    }
+    size_t cap = b->cap ? b->cap : OUT_BUF_INITIAL_CAPACITY;
+    while (cap < needed) {
+        cap *= 2;
+    }
+    char *data = realloc(b->data, cap);
+    if (!data) {
+        return -1;
+    }
+    b->data = data;
+    b->cap = cap;
+    return 0;
+}
+
+void out_buf_reset(out_buf_t *b) {
+    if (b->cap > OUT_BUF_KEEP_BYTES) {
+        free(b->data);
+        b->data = NULL;
+        b->cap = 0;
+    }
+    b->len = 0;
+    if (b->data) {
+        b->data[0] = '\0';
+    }
+}
+
+int out_buf_write(out_buf_t *b, const char *s, size_t n) {
+    if (out_buf_reserve(b, n) != 0) {
+        return -1;
+    }
+    memcpy(b->data + b->len, s, n);
+    b->len += n;
+    b->data[b->len] = '\0';
+    return (int)n;
+}
+
+int out_buf_vprintf(out_buf_t *b, const char *format, va_list args) {
+    va_list retry;
+    va_copy(retry, args);
+
+    // format straight into the spare capacity; only if it does not fit,
+    // grow to the exact size and format again
+    size_t room = b->cap > b->len ? b->cap - b->len : 0;
+    int result = vsnprintf(room ? b->data + b->len : NULL, room, format, args);
+    if (result >= 0 && (size_t)result >= room) {
+        if (out_buf_reserve(b, result) != 0) {
+            result = -1;
+        } else {
+            vsnprintf(b->data + b->len, b->cap - b->len, format, retry);
+        }
+    }
+    va_end(retry);
+
+    if (result > 0) {
+        b->len += result;
+    }
+    return result;
+}
+
+void output_init(output_t *o) {
+    memset(o, 0, sizeof(*o));
+    o->buffer_sink.write = buffer_sink_write;
+    o->sink = &o->buffer_sink;
+}
+
+void output_destroy(output_t *o) {
+    if (bound_output == o) {
+        bound_output = NULL;
+    }
+    free(o->buffer.data);
+    o->buffer.data = NULL;
+    o->buffer.len = o->buffer.cap = 0;
+}
+
+output_t *output_use(output_t *o) {
+    output_t *previous = bound_output;
+    bound_output = o;
+    return previous;
+}
+
+out_buf_t *output_buffer(void) {
+    output_t *out = current_output();
+    return &out->buffer;
+}
+
+unsigned long long output_written(void) {
+    output_t *out = current_output();
+    return out->written;
+}
+
+out_sink_t *output_set_sink(out_sink_t *sink) {
+    output_t *out = current_output();
+    out_sink_t *previous = out->sink;
+    out->sink = sink ? sink : &out->buffer_sink;
+    return previous;
+}
+
+out_sink_t *output_sink(void) {
+    output_t *out = current_output();
+    return out->sink;
+}
+
+bool output_closed(void) {
+    output_t *out = current_output();
+    return out->sink->closed;
+}
+
+int output_write(const char *data, size_t len) {
+    output_t *out = current_output();
+    if (out->sink->closed) {
+        return -1;
+    }
+    return out->sink->write(out->sink, data, len);
+}
+
+int custom_printf(const char *format, ...) {
+    output_t *out = current_output();
+    va_list args;
+    int result;
+
+    va_start(args, format);
+    if (out->sink == &out->buffer_sink) {
+        // common case: format straight into the output buffer
+        result = out_buf_vprintf(&out->buffer, format, args);
+        if (result > 0) {
+            out->written += result;
+        }
+    } else if (out->sink->closed) {
+        result = -1;
+    } else {
+        // format on the stack (or the heap, for long text) and hand the bytes
+        // to the sink; sinks may print themselves, so no shared scratch buffer
+        char stack[OUT_FORMAT_STACK_BYTES];
+        char *text = stack;
+        va_list retry;
+        va_copy(retry, args);
+        result = vsnprintf(stack, sizeof(stack), format, args);
+        if (result >= (int)sizeof(stack)) {
+            text = malloc(result + 1);
+            if (text) {
+                vsnprintf(text, result + 1, format, retry);
+            } else {
+                result = -1;
+            }
+        }
+        va_end(retry);
+        if (result > 0 && out->sink->write(out->sink, text, result) != 0) {
+            result = -1;
+        }
+        if (text != stack) {
+            free(text);
+        }
+    }
+    va_end(args);
+    return result;
+}
@@ -0,0 +1,94 @@
+#ifndef _OUTPUT_H
+#define _OUTPUT_H
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * Growable output buffer. The data is kept contiguous and NUL-terminated,
+ * so a front end can hand it off as one (pointer, length) region.
+ */
+typedef struct out_buf {
+    char *data;               /* Buffered bytes, NUL-terminated (may be NULL). */
+    size_t len;               /* Number of bytes buffered. */
+    size_t cap;               /* Bytes allocated for data. */
+} out_buf_t;
+
+/* Buffers larger than this are released on reset rather than kept. */
+#define OUT_BUF_KEEP_BYTES (64 * 1024)
+
+/* A front end that writes the buffer out and resets it once it holds this
+ * much keeps reusing one allocation, since the capacity (doubled, with
+ * room for the NUL) then stays within OUT_BUF_KEEP_BYTES. */
+#define OUT_BUF_FLUSH_BYTES (OUT_BUF_KEEP_BYTES / 2)
+
+/** Empty the buffer, keeping its memory unless it grew past
+ *  OUT_BUF_KEEP_BYTES. */
+void out_buf_reset(out_buf_t *b);
+
+/** Append n bytes. Returns n, or -1 if memory is exhausted. */
+int out_buf_write(out_buf_t *b, const char *s, size_t n);
+
+/** Append formatted text. Returns the number of bytes written, or -1. */
+int out_buf_vprintf(out_buf_t *b, const char *format, va_list args);
+
+/** The buffer the shell's commands print into by default. */
+out_buf_t *output_buffer(void);
+
+/** Total bytes that have reached the output buffer, across resets. */
+unsigned long long output_written(void);
+
+/**
+ * Destination for command output. By default commands print into the
+ * output buffer; a pipeline points the current sink at the next stage.
+ */
+typedef struct out_sink out_sink_t;
+struct out_sink {
+    /** Consume len bytes. Returns 0, or -1 once the sink accepts no more. */
+    int (*write)(out_sink_t *sink, const char *data, size_t len);
+    bool closed;              /* Set once the sink accepts no more output. */
+};
+
+/**
+ * Everything commands print into: the output buffer with its sink and the
+ * current sink. Each thread prints into one at a time, selected with
+ * output_use; the functions here act on it, and calling them with none
+ * selected is a bug, caught by an assert.
+ */
+typedef struct output {
+    out_sink_t buffer_sink;   /* Appends to buffer; must be first. */
+    out_buf_t buffer;
+    unsigned long long written;   /* See output_written. */
+    out_sink_t *sink;         /* The current sink. */
+} output_t;
+
+/** Set up an empty output, its current sink being its buffer. */
+void output_init(output_t *o);
+
+/** Free the buffer of an output. If it is the calling thread's, the
+ *  thread is left without one. */
+void output_destroy(output_t *o);
+
+/** Make o the calling thread's output (NULL for none) and return the
+ *  previous one. */
+output_t *output_use(output_t *o);
+
+/** Make sink the current sink (NULL means the output buffer) and return
+ *  the previous one. */
+out_sink_t *output_set_sink(out_sink_t *sink);
+
+/** The current sink. */
+out_sink_t *output_sink(void);
+
+/** True once the current sink accepts no more output, so producers can
+ *  stop early (e.g. the rest of a pipeline only wanted the first lines). */
+bool output_closed(void);
+
+/** Send len bytes to the current sink. Returns 0, or -1 if it is closed. */
+int output_write(const char *data, size_t len);
+
+/** printf into the current sink; used by every shell command. */
+int custom_printf(const char *format, ...);
+
+#endif /* ifndef _OUTPUT_H */
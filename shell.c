@@ -3,43 +3,77 @@
 #include <stdbool.h>
 #include <stdlib.h>
 #include "vect.h"
+#include "alloc.h"
+#include "vfs.h"
+#include "output.h"
+#include "shell.h"
+#include "filters.h"
+#include "snapshot.h"
+#include "journal.h"
+#include "stats.h"
+#include "glob.h"
 #include "string.h"
 #include <dirent.h>
+#include <pthread.h>
 #include <sys/stat.h>
 #include <time.h>
 #include <unistd.h>
 #include <errno.h>
+#include <assert.h>
 
-#define MAX_INPUT_SIZE 255
 #define MAX_PATH_SIZE 1024
-#define MAX_CONTENT_SIZE 4096
 
-// Current working directory state
-static char current_dir[MAX_PATH_SIZE] = "/home";
-static char previous_dir[MAX_PATH_SIZE] = "/home";
-
-// Forward declarations
-extern int custom_printf(const char* format, ...);
-extern int is_special_character(char ch);
-extern int read_quoted_string(const char *input, char *output);
-extern int read_word(const char *input, char *output);
-void process_command(char *input, vect_t *args_vector);
-
-// Virtual filesystem structure
+/**
+ * A working directory: the entry it was resolved to, watched by the
+ * filesystem so it is followed wherever it is moved (see vfs_watch), and
+ * the path it was last known by, looked up again once the entry is
+ * removed.
+ */
 typedef struct {
-    char name[256];
-    bool is_dir;
-    char content[MAX_CONTENT_SIZE];
-    time_t created;
-    time_t modified;
-} fs_entry_t;
+    fs_entry_t* entry;              // NULL until resolved again
+    char path[MAX_PATH_SIZE];
+} work_dir_t;
 
+/** The counters of a pipeline of several commands, under their names
+ *  joined by " | ". */
 typedef struct {
-    fs_entry_t entries[100];
-    int count;
-} fs_dir_t;
+    char* name;
+    stats_counter_t counter;
+} pipeline_stats_t;
 
-static fs_dir_t virtual_fs = {0};
+/**
+ * Everything one shell owns: its working directories, filesystem, output
+ * and journal, and the caches and counters of the commands it runs.
+ * Sessions share no mutable state, so any thread can drive any session,
+ * one thread at a time. The caches and counters are allocated when first
+ * used.
+ */
+struct shell_session {
+    work_dir_t current_dir;
+    work_dir_t previous_dir;        // for cd -
+    vfs_t* fs;
+    output_t output;
+    journal_t journal;
+
+    // Scratch memory for the command being processed (tokens, argv);
+    // rewound when process_command returns
+    arena_t command_arena;
+
+    struct line_cache* lines;       // see line_cache_find
+    unsigned long line_hits;
+    unsigned long line_misses;
+    mem_pool_t line_pool;           // blocks of the line cache
+    struct script_cache* scripts;   // see load_script
+    glob_index_t* globs;            // see expand_command
+    int source_depth;
+    struct file_sink* open_files;   // see open_output
+    stats_counter_t* stats;         // by index in the builtin table
+    pipeline_stats_t* pipeline_stats;   // see pipeline_counter
+    size_t pipeline_stats_count;
+};
+
+// The session the calling thread works on, see shell_session_use
+static _Thread_local shell_session_t* current_session = NULL;
 
 // Add the readme content as a constant
 const char* README_CONTENT = "Available commands:\n\n"
@@ -51,509 +85,1961 @@ const char* README_CONTENT = "Available commands:\n\n"
     "touch   - Create a new empty file\n"
     "mkdir   - Create a new directory\n"
     "rm      - Remove a file or directory\n"
+    "cp      - Copy files\n"
+    "mv      - Move or rename files\n"
+    "grep    - Print lines matching a pattern\n"
+    "wc      - Count lines, words and bytes\n"
+    "head    - Show the first lines of input\n"
+    "tail    - Show the last lines of input\n"
+    "sort    - Sort lines of input\n"
+    "uniq    - Collapse repeated lines\n"
+    "source  - Run the commands in a file\n"
+    "stats   - Show how often and how fast commands ran\n"
+    "time    - Report the cost of running a command\n"
     "date    - Show current date and time\n"
     "whoami  - Show current user\n"
     "clear   - Clear terminal screen\n"
     "help    - Show detailed command help\n"
     "readme  - Show this command list\n";
 
-// Initialize virtual filesystem
-void init_fs() {
-    if (virtual_fs.count == 0) {
-        // Add root directory
-        strcpy(virtual_fs.entries[0].name, "/");
-        virtual_fs.entries[0].is_dir = true;
-        virtual_fs.entries[0].created = time(NULL);
-        virtual_fs.entries[0].modified = time(NULL);
-        
-        // Add home directory
-        strcpy(virtual_fs.entries[1].name, "/home");
-        virtual_fs.entries[1].is_dir = true;
-        virtual_fs.entries[1].created = time(NULL);
-        virtual_fs.entries[1].modified = time(NULL);
-
-        // Add README.md to home directory
-        strcpy(virtual_fs.entries[2].name, "/home/README.md");
-        virtual_fs.entries[2].is_dir = false;
-        virtual_fs.entries[2].created = time(NULL);
-        virtual_fs.entries[2].modified = time(NULL);
-        strncpy(virtual_fs.entries[2].content, README_CONTENT, MAX_CONTENT_SIZE - 1);
-        
-        virtual_fs.count = 3;
-    }
-}
-
-// Helper function to find a file/directory in virtual filesystem
-fs_entry_t* find_fs_entry(const char* path) {
-    for (int i = 0; i < virtual_fs.count; i++) {
-        if (strcmp(virtual_fs.entries[i].name, path) == 0) {
-            return &virtual_fs.entries[i];
-        }
-    }
-    return NULL;
+// Create the initial filesystem
+static void seed_fs(void) {
+    add_fs_entry("/", true);
+    add_fs_entry("/home", true);
+
+    // Add README.md to home directory
+    fs_entry_t* readme = add_fs_entry("/home/README.md", false);
+    fs_set_content(readme, README_CONTENT, strlen(README_CONTENT));
 }
 
-// Helper function to add a new filesystem entry
-fs_entry_t* add_fs_entry(const char* path, bool is_dir) {
-    if (virtual_fs.count >= 100) {
-        return NULL;
+// The initial filesystem as a frozen image, shared by the sessions made
+// with shell_session_new
+static vfs_t* seed_image = NULL;
+static pthread_once_t seed_image_once = PTHREAD_ONCE_INIT;
+
+static void seed_image_init(void) {
+    vfs_t* image = vfs_new();
+    if (!image) {
+        return;
     }
-    
-    fs_entry_t* entry = &virtual_fs.entries[virtual_fs.count++];
-    strncpy(entry->name, path, 255);
-    entry->is_dir = is_dir;
-    entry->created = time(NULL);
-    entry->modified = time(NULL);
-    if (!is_dir) {
-        entry->content[0] = '\0';
+    journal_t quiet = {0};      // not a change of any session
+    vfs_t* previous_fs = vfs_use(image);
+    journal_t* previous_journal = journal_use(&quiet);
+    seed_fs();
+    journal_use(previous_journal);
+    vfs_use(previous_fs);
+    vfs_freeze(image);
+    seed_image = image;
+}
+
+// Initialize the virtual filesystem of a session, which must be the
+// calling thread's
+static void init_fs(shell_session_t* session) {
+    assert(current_session == session && "session not selected, see shell_session_use");
+    if (fs_root() == NULL) {
+        // Back to the base image if there is one, else build a private copy
+        fs_revert();
+        if (fs_root() == NULL) {
+            seed_fs();
+        }
     }
-    return entry;
 }
 
 /**
- * Function which prints the help information
+ * trims off trailing newlines '\n' from a string
  */
-void print_help() {
-    custom_printf("Built-in commands:\n");
-    custom_printf("1. ls [-l]\n");
-    custom_printf("   List files in the current directory.\n");
-    custom_printf("   -l: show in long format with details\n\n");
-
-    custom_printf("2. cd <directory>\n");
-    custom_printf("   Change the current directory.\n");
-    custom_printf("   Usage: cd <path> or cd - for previous directory\n\n");
+void trim_newline(char *str) {
+    size_t len = strlen(str);
+    if (len > 0 && str[len - 1] == '\n') {
+        str[len - 1] = '\0';
+    }
+}
 
-    custom_printf("3. pwd\n");
-    custom_printf("   Print working directory.\n");
-    custom_printf("   Usage: pwd\n\n");
+/** One simple command of a pipeline, with its redirections. */
+typedef struct {
+    int argc;
+    const char** argv;      // NULL-terminated
+    const bool* patterns;   // per word, unquoted with *, ? or [; NULL if none is
+    const char* input_file;     // '<' target, or NULL
+    const char* output_file;    // '>' or '>>' target, or NULL
+    bool append;                // output_file came with '>>'
+} command_t;
+
+/** Commands connected by '|', in order. */
+typedef struct {
+    int count;
+    command_t* commands;
+} pipeline_t;
 
-    custom_printf("4. echo <text>\n");
-    custom_printf("   Print text to the terminal.\n");
-    custom_printf("   Usage: echo Hello World\n\n");
+/** Pipelines run one after another: separated by ';', or the lines of a
+ *  script. */
+typedef struct {
+    int count;
+    int capacity;
+    pipeline_t* pipelines;
+    const char* unexpected;     // the offending token after a syntax error
+} command_list_t;
+
+/** The special character a token stands for, or '\0' for a word. */
+static char token_special(const char* input, const token_span_t* span) {
+    return span->kind == TOKEN_SPECIAL ? input[span->offset] : '\0';
+}
 
-    custom_printf("5. cat <file>\n");
-    custom_printf("   Display contents of a file.\n");
-    custom_printf("   Usage: cat file.txt\n\n");
+/** Is a token a word to expand as a pattern (see glob.h)? Quoted strings
+ *  are taken as they are. */
+static bool is_pattern(const char* input, const token_span_t* span) {
+    return span->kind == TOKEN_WORD && glob_is_pattern(input + span->offset, span->length);
+}
 
-    custom_printf("6. touch <file>\n");
-    custom_printf("   Create a new empty file.\n");
-    custom_printf("   Usage: touch file.txt\n\n");
+static bool command_empty(const command_t* command) {
+    return command->argc == 0 && !command->input_file && !command->output_file;
+}
 
-    custom_printf("7. mkdir <directory>\n");
-    custom_printf("   Create a new directory.\n");
-    custom_printf("   Usage: mkdir mydir\n\n");
+/**
+ * builds a pipeline from count token spans of input, all allocated from
+ * the arena. '<', '>' and '>>' take the next word as their file. Returns
+ * 0, -1 if memory is exhausted, or 1 after a syntax error, with
+ * *unexpected set
+ */
+static int parse_pipeline(arena_t* arena, const char* input, const token_span_t* spans, int count,
+                          pipeline_t* pipeline, const char** unexpected) {
+    // Only an unquoted '|' separates commands
+    int stages = 1;
+    for (int i = 0; i < count; i++) {
+        if (token_special(input, &spans[i]) == '|') {
+            stages++;
+        }
+    }
 
-    custom_printf("8. rm <file/directory>\n");
-    custom_printf("   Remove a file or directory.\n");
-    custom_printf("   Usage: rm file.txt\n\n");
+    // Every command's argv lives in one array, each followed by its NULL,
+    // and so do the pattern flags when any word is a pattern
+    const char** argv = arena_alloc(arena, (count + stages) * sizeof(char*));
+    command_t* commands = arena_alloc(arena, stages * sizeof(command_t));
+    if (!argv || !commands) {
+        return -1;
+    }
+    memset(commands, 0, stages * sizeof(command_t));
+    const char** first_argv = argv;
+    bool* patterns = NULL;
+    for (int i = 0; i < count && !patterns; i++) {
+        if (is_pattern(input, &spans[i])) {
+            if (!(patterns = arena_alloc(arena, (count + stages) * sizeof(bool)))) {
+                return -1;
+            }
+            memset(patterns, 0, (count + stages) * sizeof(bool));
+        }
+    }
 
-    custom_printf("9. date\n");
-    custom_printf("   Display current date and time.\n");
-    custom_printf("   Usage: date\n\n");
+    command_t* command = commands;
+    command->argv = argv;
+    *unexpected = "|";
+    for (int i = 0; i < count; i++) {
+        char special = token_special(input, &spans[i]);
+        if (special == '|') {
+            if (command_empty(command)) {
+                return 1;
+            }
+            *argv++ = NULL;
+            command++;
+            command->argv = argv;
+            continue;
+        }
 
-    custom_printf("10. whoami\n");
-    custom_printf("    Display current user.\n");
-    custom_printf("    Usage: whoami\n\n");
+        if (special == '<' || special == '>') {
+            // '>>' arrives as two adjacent '>' tokens
+            bool append = special == '>' && i + 1 < count &&
+                          token_special(input, &spans[i + 1]) == '>' &&
+                          spans[i + 1].offset == spans[i].offset + 1;
+            if (append) {
+                i++;
+            }
+            if (i + 1 >= count || token_special(input, &spans[i + 1])) {
+                *unexpected = i + 1 >= count ? "newline"
+                    : arena_strndup(arena, input + spans[i + 1].offset, 1);
+                return *unexpected ? 1 : -1;
+            }
+            i++;
+            const char* file = arena_strndup(arena, input + spans[i].offset, spans[i].length);
+            if (!file) {
+                return -1;
+            }
+            if (special == '<') {
+                command->input_file = file;
+            } else {
+                command->output_file = file;
+                command->append = append;
+            }
+            continue;
+        }
 
-    custom_printf("11. clear\n");
-    custom_printf("    Clear the terminal screen.\n");
-    custom_printf("    Usage: clear\n\n");
+        if (is_pattern(input, &spans[i])) {
+            patterns[argv - first_argv] = true;
+            command->patterns = patterns + (command->argv - first_argv);
+        }
+        *argv = arena_strndup(arena, input + spans[i].offset, spans[i].length);
+        if (!*argv++) {
+            return -1;
+        }
+        command->argc++;
+    }
+    *argv = NULL;
+    if (command_empty(command) && stages > 1) {
+        return 1;
+    }
 
-    custom_printf("12. help\n");
-    custom_printf("    Display this help information.\n");
-    custom_printf("    Usage: help\n");
+    pipeline->count = stages;
+    pipeline->commands = commands;
+    return 0;
 }
 
-/**
- * trims off trailing newlines '\n' from a string
- */
-void trim_newline(char *str) {
-    size_t len = strlen(str);
-    if (len > 0 && str[len - 1] == '\n') {
-        str[len - 1] = '\0';
+/** Append an empty pipeline to the list and return it, or NULL. */
+static pipeline_t* command_list_add(arena_t* arena, command_list_t* list) {
+    if (list->count == list->capacity) {
+        int capacity = list->capacity ? list->capacity * 2 : 4;
+        pipeline_t* pipelines = arena_alloc(arena, capacity * sizeof(pipeline_t));
+        if (!pipelines) {
+            return NULL;
+        }
+        if (list->count > 0) {
+            memcpy(pipelines, list->pipelines, list->count * sizeof(pipeline_t));
+        }
+        list->pipelines = pipelines;
+        list->capacity = capacity;
     }
+    return &list->pipelines[list->count++];
 }
 
 /**
- * tokenizes a user input and returns a vector containing
- * all of the tokens
+ * tokenizes one line of input and appends its pipelines, split on ';', to
+ * the list, all allocated from the arena; the input is scanned into spans
+ * first so only the token bytes themselves are copied. Returns 0, -1 if
+ * memory is exhausted, or 1 after a syntax error, with list->unexpected
+ * set
  */
-vect_t* tokenize_input(const char *input) {
-    vect_t *tokens = vect_new();
-    char buf[256];
-    int i = 0;
-
-    while (input[i] != '\0') {
-        if (input[i] == ' ') {
-            ++i;
-            continue;
+int parse_line(arena_t* arena, const char *input, command_list_t* list) {
+    token_span_t small_spans[32];
+    token_span_t* spans = small_spans;
+
+    int count = tokenize_spans(input, spans, 32);
+    if (count > 32) {
+        spans = arena_alloc(arena, count * sizeof(token_span_t));
+        if (!spans) {
+            return -1;
         }
-        if (input[i] == '"') {
-            i += read_quoted_string(&input[i], buf);
-            vect_add(tokens, buf);
+        tokenize_spans(input, spans, count);
+    }
+
+    // A trailing ';' is allowed, an empty command before one is not
+    int start = 0;
+    for (int i = 0; i <= count; i++) {
+        if (i < count && token_special(input, &spans[i]) != ';') {
             continue;
         }
-        if (is_special_character(input[i])) {
-            buf[0] = input[i];
-            buf[1] = '\0';
-            vect_add(tokens, buf);
-            ++i;
-            continue;
+        if (i == start) {
+            if (i < count) {
+                list->unexpected = ";";
+                return 1;
+            }
+            break;
+        }
+        pipeline_t* pipeline = command_list_add(arena, list);
+        if (!pipeline) {
+            return -1;
         }
-        i += read_word(&input[i], buf);
-        vect_add(tokens, buf);
+        int result = parse_pipeline(arena, input, spans + start, i - start, pipeline,
+                                    &list->unexpected);
+        if (result != 0) {
+            return result;
+        }
+        start = i + 1;
     }
-    return tokens;
+    return 0;
 }
 
 /**
  * Implementation of basic shell commands
  */
 
-void cmd_pwd() {
-    custom_printf("%s\n", current_dir);
+/** The entry of a working directory, as it is now: a directory of the
+ *  base image may have been copied into the overlay since. If the entry
+ *  was removed, its path is looked up again. NULL if there is no
+ *  directory there. */
+static fs_entry_t* work_dir_entry(work_dir_t* dir) {
+    if (dir->entry) {
+        dir->entry = fs_resolve(dir->entry, ".");
+    }
+    if (!dir->entry) {
+        fs_entry_t* entry = find_fs_entry(dir->path);
+        dir->entry = entry && entry->is_dir ? entry : NULL;
+    }
+    return dir->entry;
 }
 
-void cmd_cd(const char* path) {
-    if (!path) {
-        custom_printf("cd: missing argument\n");
-        return;
+/** The path of a working directory, brought up to date if it was moved
+ *  (unless the new one does not fit). */
+static const char* work_dir_path(work_dir_t* dir) {
+    if (work_dir_entry(dir)) {
+        fs_entry_path(dir->entry, dir->path, MAX_PATH_SIZE);
     }
+    return dir->path;
+}
+
+/** Find the entry at a path, relative to the current directory unless it
+ *  is absolute (see fs_resolve). */
+static fs_entry_t* resolve_path(shell_session_t* session, const char* path) {
+    return fs_resolve(path[0] == '/' ? NULL : work_dir_entry(&session->current_dir), path);
+}
+
+/** Find the entry that would hold the last component of a path, like
+ *  resolve_path (see fs_resolve_parent). */
+static fs_entry_t* resolve_parent(shell_session_t* session, const char* path, const char** name,
+                                  size_t* len) {
+    fs_entry_t* dir = path[0] == '/' ? NULL : work_dir_entry(&session->current_dir);
+    return fs_resolve_parent(dir, path, name, len);
+}
+
+/** Create an entry at a path, like resolve_path. Returns NULL and sets
+ *  errno like add_fs_entry on failure. */
+static fs_entry_t* create_path(shell_session_t* session, const char* path, bool is_dir) {
+    const char* name;
+    size_t len;
+    fs_entry_t* dir = resolve_parent(session, path, &name, &len);
+    if (!dir || len == 0) {
+        errno = dir ? EEXIST : ENOENT;
+        return NULL;
+    }
+    return fs_add_child(dir, name, len, is_dir);
+}
+
+int cmd_pwd(shell_session_t* session, int argc, const char** argv) {
+    custom_printf("%s\n", work_dir_path(&session->current_dir));
+    return 0;
+}
+
+int cmd_cd(shell_session_t* session, int argc, const char** argv) {
+    const char* path = argv[1];
 
     // Handle cd - to go to previous directory
     if (strcmp(path, "-") == 0) {
-        char temp[MAX_PATH_SIZE];
-        strncpy(temp, current_dir, MAX_PATH_SIZE);
-        strncpy(current_dir, previous_dir, MAX_PATH_SIZE);
-        strncpy(previous_dir, temp, MAX_PATH_SIZE);
-        return;
+        work_dir_t temp = session->current_dir;
+        session->current_dir = session->previous_dir;
+        session->previous_dir = temp;
+        return 0;
     }
 
     // Store current directory before changing
-    strncpy(previous_dir, current_dir, MAX_PATH_SIZE);
-
-    char new_path[MAX_PATH_SIZE];
-    if (path[0] == '/') {
-        // Absolute path
-        strncpy(new_path, path, MAX_PATH_SIZE - 1);
-    } else if (strcmp(path, "..") == 0) {
-        // Go up one directory
-        char* last_slash = strrchr(current_dir, '/');
-        if (last_slash != current_dir) {
-            *last_slash = '\0';
-        }
-        return;
-    } else {
-        // Relative path
-        snprintf(new_path, MAX_PATH_SIZE, "%s/%s", current_dir, path);
-    }
+    work_dir_path(&session->current_dir);
+    session->previous_dir = session->current_dir;
 
     // Check if directory exists in virtual filesystem
-    fs_entry_t* entry = find_fs_entry(new_path);
+    fs_entry_t* entry = resolve_path(session, path);
     if (!entry || !entry->is_dir) {
         custom_printf("cd: %s: No such directory\n", path);
-        return;
+        return 1;
     }
 
     // Update current directory
-    strncpy(current_dir, new_path, MAX_PATH_SIZE - 1);
+    session->current_dir.entry = entry;
+    work_dir_path(&session->current_dir);
+    return 0;
 }
 
-void cmd_ls(vect_t* args) {
+int cmd_ls(shell_session_t* session, int argc, const char** argv) {
     bool long_format = false;
     
     // Check for -l flag
-    for (int i = 1; i < vect_size(args); i++) {
-        if (strcmp(vect_get(args, i), "-l") == 0) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-l") == 0) {
             long_format = true;
             break;
         }
     }
 
-    // Show virtual filesystem entries in current directory
+    fs_entry_t* dir = work_dir_entry(&session->current_dir);
+    if (!dir) {
+        custom_printf("ls: cannot access '%s': No such directory\n", session->current_dir.path);
+        return 1;
+    }
+
+    // Show the children of the current directory
     if (long_format) {
-        custom_printf("total %d\n", virtual_fs.count);
+        custom_printf("total %u\n", dir->child_count);
     }
 
-    for (int i = 0; i < virtual_fs.count; i++) {
-        fs_entry_t* entry = &virtual_fs.entries[i];
-        char* entry_name = strrchr(entry->name, '/');
-        if (!entry_name) {
-            entry_name = entry->name;
+    for (fs_entry_t* entry = fs_first_child(dir); entry && !output_closed(); entry = fs_next_sibling(entry)) {
+        const char* entry_name = fs_entry_basename(entry);
+        if (long_format) {
+            char time_str[26];
+            ctime_r(&entry->modified, time_str);
+            time_str[24] = '\0'; // Remove newline
+            custom_printf("%s  -  guest  guest  %s  %s\n",
+                entry->is_dir ? "drwxr-xr-x" : "-rw-r--r--",
+                time_str,
+                entry_name);
         } else {
-            entry_name++; // Skip the slash
-        }
-
-        // Only show entries in current directory
-        char dir_path[MAX_PATH_SIZE];
-        strncpy(dir_path, entry->name, MAX_PATH_SIZE);
-        char* last_slash = strrchr(dir_path, '/');
-        if (last_slash) {
-            *last_slash = '\0';
-        }
-        
-        if (strcmp(dir_path, current_dir) == 0) {
-            if (long_format) {
-                char time_str[26];
-                ctime_r(&entry->modified, time_str);
-                time_str[24] = '\0'; // Remove newline
-                custom_printf("%s  -  guest  guest  %s  %s\n",
-                    entry->is_dir ? "drwxr-xr-x" : "-rw-r--r--",
-                    time_str,
-                    entry_name);
-            } else {
-                custom_printf("%s\n", entry_name);
-            }
+            custom_printf("%s\n", entry_name);
         }
     }
+    return 0;
 }
 
-void cmd_echo(vect_t* args) {
-    for (int i = 1; i < vect_size(args); i++) {
-        custom_printf("%s", (char*)vect_get(args, i));
-        if (i < vect_size(args) - 1) {
+int cmd_echo(shell_session_t* session, int argc, const char** argv) {
+    for (int i = 1; i < argc; i++) {
+        custom_printf("%s", argv[i]);
+        if (i < argc - 1) {
             custom_printf(" ");
         }
     }
     custom_printf("\n");
+    return 0;
 }
 
-void cmd_cat(const char* filename) {
-    if (!filename) {
-        custom_printf("cat: missing file operand\n");
-        return;
+/**
+ * writes a file's content, ending it with a newline if it lacks one; the
+ * bytes go to the sink unformatted, so a pipeline that stops early never
+ * copies the rest
+ */
+static void print_content(const fs_entry_t* entry) {
+    if (entry->size > 0) {
+        output_write(entry->content, entry->size);
+        if (entry->content[entry->size - 1] != '\n') {
+            output_write("\n", 1);
+        }
     }
+}
 
+static int cat_file(shell_session_t* session, const char* filename) {
     // Special handling for readme variations
     if (strcasecmp(filename, "readme") == 0 || 
         strcasecmp(filename, "readme.md") == 0 || 
         strcasecmp(filename, "readme.txt") == 0) {
         // If in home directory, show the README.md
-        if (strcmp(current_dir, "/home") == 0) {
+        if (work_dir_entry(&session->current_dir) == find_fs_entry("/home")) {
             fs_entry_t* entry = find_fs_entry("/home/README.md");
             if (entry) {
-                custom_printf("%s", entry->content);
-                if (entry->content[0] != '\0') {
-                    custom_printf("\n");
-                }
-                return;
+                print_content(entry);
+                return 0;
             }
         }
     }
 
-    char full_path[MAX_PATH_SIZE];
-    if (filename[0] == '/') {
-        strncpy(full_path, filename, MAX_PATH_SIZE);
-    } else {
-        snprintf(full_path, MAX_PATH_SIZE, "%s/%s", current_dir, filename);
-    }
-
-    fs_entry_t* entry = find_fs_entry(full_path);
+    fs_entry_t* entry = resolve_path(session, filename);
     if (!entry || entry->is_dir) {
         // Try with .md extension if file not found
         if (!strstr(filename, ".")) {
             char with_ext[MAX_PATH_SIZE];
-            snprintf(with_ext, MAX_PATH_SIZE, "%s.md", full_path);
-            entry = find_fs_entry(with_ext);
+            snprintf(with_ext, MAX_PATH_SIZE, "%s.md", filename);
+            entry = resolve_path(session, with_ext);
             if (entry && !entry->is_dir) {
-                custom_printf("%s", entry->content);
-                if (entry->content[0] != '\0') {
-                    custom_printf("\n");
-                }
-                return;
+                print_content(entry);
+                return 0;
             }
         }
         custom_printf("cat: %s: No such file\n", filename);
-        return;
+        return 1;
     }
 
-    custom_printf("%s", entry->content);
-    if (entry->content[0] != '\0') {
-        custom_printf("\n");
-    }
+    print_content(entry);
+    return 0;
 }
 
-void cmd_touch(const char* filename) {
-    if (!filename) {
-        custom_printf("touch: missing file operand\n");
-        return;
-    }
-
-    char full_path[MAX_PATH_SIZE];
-    if (filename[0] == '/') {
-        strncpy(full_path, filename, MAX_PATH_SIZE);
-    } else {
-        snprintf(full_path, MAX_PATH_SIZE, "%s/%s", current_dir, filename);
+int cmd_cat(shell_session_t* session, int argc, const char** argv) {
+    int status = 0;
+    for (int i = 1; i < argc && !output_closed(); i++) {
+        status |= cat_file(session, argv[i]);
     }
+    return status;
+}
 
-    fs_entry_t* entry = find_fs_entry(full_path);
+static int touch_file(shell_session_t* session, const char* filename) {
+    fs_entry_t* entry = resolve_path(session, filename);
     if (entry) {
         // Update modification time if file exists
-        entry->modified = time(NULL);
+        fs_touch(entry, time(NULL));
     } else {
         // Create new file
-        if (!add_fs_entry(full_path, false)) {
-            custom_printf("touch: cannot create file '%s': Filesystem full\n", filename);
+        if (!create_path(session, filename, false)) {
+            custom_printf("touch: cannot create file '%s': %s\n", filename, strerror(errno));
+            return 1;
         }
     }
+    return 0;
 }
 
-void cmd_mkdir(const char* dirname) {
-    if (!dirname) {
-        custom_printf("mkdir: missing operand\n");
-        return;
+int cmd_touch(shell_session_t* session, int argc, const char** argv) {
+    int status = 0;
+    for (int i = 1; i < argc; i++) {
+        status |= touch_file(session, argv[i]);
     }
+    return status;
+}
 
-    char full_path[MAX_PATH_SIZE];
-    if (dirname[0] == '/') {
-        strncpy(full_path, dirname, MAX_PATH_SIZE);
-    } else {
-        snprintf(full_path, MAX_PATH_SIZE, "%s/%s", current_dir, dirname);
+static int make_directory(shell_session_t* session, const char* dirname) {
+    if (!create_path(session, dirname, true)) {
+        custom_printf("mkdir: cannot create directory '%s': %s\n", dirname, strerror(errno));
+        return 1;
     }
+    return 0;
+}
 
-    if (find_fs_entry(full_path)) {
-        custom_printf("mkdir: cannot create directory '%s': File exists\n", dirname);
-        return;
+int cmd_mkdir(shell_session_t* session, int argc, const char** argv) {
+    int status = 0;
+    for (int i = 1; i < argc; i++) {
+        status |= make_directory(session, argv[i]);
     }
+    return status;
+}
 
-    if (!add_fs_entry(full_path, true)) {
-        custom_printf("mkdir: cannot create directory '%s': Filesystem full\n", dirname);
+/** Does a path end in "." or ".."? */
+static bool is_dot_path(const char* path) {
+    size_t end = strlen(path);
+    while (end > 1 && path[end - 1] == '/') {
+        end--;
+    }
+    size_t start = end;
+    while (start > 0 && path[start - 1] != '/') {
+        start--;
     }
+    return path[start] == '.' && (end - start == 1 || (end - start == 2 && path[start + 1] == '.'));
 }
 
-void cmd_rm(const char* path) {
-    if (!path) {
+int cmd_rm(shell_session_t* session, int argc, const char** argv) {
+    bool recursive = false;
+    int operands = 0;
+    int status = 0;
+
+    // Check for -r flag
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        if (strcmp(arg, "-r") == 0 || strcmp(arg, "-R") == 0) {
+            recursive = true;
+        } else {
+            operands++;
+        }
+    }
+
+    if (operands == 0) {
         custom_printf("rm: missing operand\n");
-        return;
+        return 1;
     }
 
-    char full_path[MAX_PATH_SIZE];
-    if (path[0] == '/') {
-        strncpy(full_path, path, MAX_PATH_SIZE);
-    } else {
-        snprintf(full_path, MAX_PATH_SIZE, "%s/%s", current_dir, path);
+    for (int i = 1; i < argc; i++) {
+        const char* path = argv[i];
+        if (strcmp(path, "-r") == 0 || strcmp(path, "-R") == 0) {
+            continue;
+        }
+
+        if (is_dot_path(path)) {
+            custom_printf("rm: refusing to remove '.' or '..' directory: skipping '%s'\n", path);
+            status = 1;
+            continue;
+        }
+        fs_entry_t* entry = resolve_path(session, path);
+        if (!entry) {
+            custom_printf("rm: cannot remove '%s': No such file or directory\n", path);
+            status = 1;
+            continue;
+        }
+
+        int result = recursive ? remove_fs_tree(entry) : remove_fs_entry(entry);
+        if (result != 0) {
+            custom_printf("rm: cannot remove '%s': %s\n", path, strerror(errno));
+            status = 1;
+        }
+    }
+    return status;
+}
+
+/**
+ * Find where cp or mv puts source entry from for destination dest: into
+ * dest under the source's name if dest is a directory, else at dest
+ * itself. Returns the directory and points *name and *len at the name, or
+ * returns NULL with errno set to ENOENT. *into tells which it was.
+ */
+static fs_entry_t* resolve_target(shell_session_t* session, const char* dest, const fs_entry_t* from,
+                                  const char** name, size_t* len, bool* into) {
+    fs_entry_t* dir = resolve_path(session, dest);
+    *into = dir && dir->is_dir;
+    if (*into) {
+        *name = fs_entry_basename(from);
+        *len = strlen(*name);
+        return dir;
     }
+    if (!(dir = resolve_parent(session, dest, name, len))) {
+        errno = ENOENT;
+    }
+    return dir;
+}
 
-    // Find the entry index
-    int entry_index = -1;
-    for (int i = 0; i < virtual_fs.count; i++) {
-        if (strcmp(virtual_fs.entries[i].name, full_path) == 0) {
-            entry_index = i;
-            break;
+/** The destination of cp or mv as the user would name it, for messages. */
+static const char* target_path(char* buf, const char* dest, const char* name, bool into) {
+    if (!into) {
+        return dest;
+    }
+    snprintf(buf, MAX_PATH_SIZE, "%s/%s", dest, name);
+    return buf;
+}
+
+/** Copy one file, or with -r a directory, to a path, or into it if it is
+ *  a directory. The copy shares the source's content (see
+ *  fs_share_content, fs_copy_tree). */
+static int copy_file(shell_session_t* session, const char* source, const char* dest,
+                     bool recursive) {
+    fs_entry_t* from = resolve_path(session, source);
+    if (!from) {
+        custom_printf("cp: cannot stat '%s': No such file or directory\n", source);
+        return 1;
+    }
+    if (from->is_dir && !recursive) {
+        custom_printf("cp: -r not specified; omitting directory '%s'\n", source);
+        return 1;
+    }
+
+    const char* name;
+    size_t len;
+    bool into;
+    char target[MAX_PATH_SIZE];
+    fs_entry_t* dir = resolve_target(session, dest, from, &name, &len, &into);
+    fs_entry_t* to = dir ? fs_resolve(dir, name) : NULL;
+    if (from->is_dir) {
+        if (to) {
+            custom_printf("cp: cannot create directory '%s': File exists\n",
+                          target_path(target, dest, name, into));
+            return 1;
+        }
+        if (!dir || !fs_copy_tree(from, dir, name, len, time(NULL))) {
+            if (errno == EINVAL) {
+                custom_printf("cp: cannot copy a directory, '%s', into itself, '%s'\n", source, dest);
+            } else {
+                custom_printf("cp: cannot create directory '%s': %s\n", dest, strerror(errno));
+            }
+            return 1;
         }
+        return 0;
     }
+    if (to && to->is_dir) {
+        custom_printf("cp: cannot overwrite directory '%s' with non-directory\n",
+                      target_path(target, dest, name, into));
+        return 1;
+    }
+    if (to == from) {
+        custom_printf("cp: '%s' and '%s' are the same file\n", source, dest);
+        return 1;
+    }
+    if (!to && (!dir || !(to = fs_add_child(dir, name, len, false)))) {
+        custom_printf("cp: cannot create regular file '%s': %s\n", dest, strerror(errno));
+        return 1;
+    }
+    if (fs_share_content(to, from) != 0) {
+        custom_printf("cp: cannot write '%s': %s\n", dest, strerror(errno));
+        return 1;
+    }
+    fs_touch(to, time(NULL));
+    return 0;
+}
 
-    if (entry_index == -1) {
-        custom_printf("rm: cannot remove '%s': No such file or directory\n", path);
-        return;
+static bool is_recursive_flag(const char* arg) {
+    return strcmp(arg, "-r") == 0 || strcmp(arg, "-R") == 0;
+}
+
+/** Check that the destination of several operands is a directory. */
+static bool check_target_dir(shell_session_t* session, const char* command, const char* dest) {
+    fs_entry_t* dir = resolve_path(session, dest);
+    if (!dir || !dir->is_dir) {
+        custom_printf("%s: target '%s' is not a directory\n", command, dest);
+        return false;
+    }
+    return true;
+}
+
+int cmd_cp(shell_session_t* session, int argc, const char** argv) {
+    bool recursive = false;
+    int operands = 0;
+    int last = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (is_recursive_flag(argv[i])) {
+            recursive = true;
+        } else {
+            operands++;
+            last = i;
+        }
+    }
+    if (operands < 2) {
+        if (operands == 0) {
+            custom_printf("cp: missing file operand\n");
+        } else {
+            custom_printf("cp: missing destination file operand after '%s'\n", argv[last]);
+        }
+        return 1;
+    }
+
+    const char* dest = argv[last];
+    if (operands > 2 && !check_target_dir(session, "cp", dest)) {
+        return 1;
+    }
+
+    int status = 0;
+    for (int i = 1; i < last; i++) {
+        if (!is_recursive_flag(argv[i])) {
+            status |= copy_file(session, argv[i], dest, recursive);
+        }
+    }
+    return status;
+}
+
+/** Move one entry to a path, or into it if it is a directory, replacing a
+ *  file or empty directory already there. A directory moves in O(1),
+ *  whatever it holds (see fs_rename). */
+static int move_entry(shell_session_t* session, const char* source, const char* dest) {
+    fs_entry_t* from = resolve_path(session, source);
+    if (!from) {
+        custom_printf("mv: cannot stat '%s': No such file or directory\n", source);
+        return 1;
+    }
+
+    const char* name;
+    size_t len;
+    bool into;
+    char target[MAX_PATH_SIZE];
+    fs_entry_t* dir = resolve_target(session, dest, from, &name, &len, &into);
+    if (dir && fs_resolve(dir, name) == from) {
+        custom_printf("mv: '%s' and '%s' are the same file\n", source, dest);
+        return 1;
+    }
+    if (!dir || fs_rename(from, dir, name, len) != 0) {
+        if (errno == EINVAL) {
+            custom_printf("mv: cannot move '%s' to a subdirectory of itself, '%s'\n", source, dest);
+        } else if (errno == EISDIR) {
+            custom_printf("mv: cannot overwrite directory '%s' with non-directory\n",
+                          target_path(target, dest, name, into));
+        } else {
+            custom_printf("mv: cannot move '%s' to '%s': %s\n", source, dest, strerror(errno));
+        }
+        return 1;
+    }
+    return 0;
+}
+
+int cmd_mv(shell_session_t* session, int argc, const char** argv) {
+    const char* dest = argv[argc - 1];
+    if (argc > 3 && !check_target_dir(session, "mv", dest)) {
+        return 1;
     }
 
-    // Remove entry by shifting remaining entries left
-    for (int i = entry_index; i < virtual_fs.count - 1; i++) {
-        virtual_fs.entries[i] = virtual_fs.entries[i + 1];
+    int status = 0;
+    for (int i = 1; i < argc - 1; i++) {
+        status |= move_entry(session, argv[i], dest);
     }
-    virtual_fs.count--;
+    return status;
 }
 
-void cmd_date() {
+int cmd_date(shell_session_t* session, int argc, const char** argv) {
     time_t now = time(NULL);
-    char* date_str = ctime(&now);
+    char date_str[26];
+    ctime_r(&now, date_str);
     custom_printf("%s", date_str);
+    return 0;
 }
 
-void cmd_whoami() {
+int cmd_whoami(shell_session_t* session, int argc, const char** argv) {
     custom_printf("guest\n");
+    return 0;
 }
 
-void cmd_clear() {
+int cmd_clear(shell_session_t* session, int argc, const char** argv) {
     custom_printf("\033[2J\033[H");  // ANSI escape sequence to clear screen
+    return 0;
 }
 
-void cmd_readme() {
+int cmd_readme(shell_session_t* session, int argc, const char** argv) {
     custom_printf("%s", README_CONTENT);
+    return 0;
 }
 
 /**
- * Process and execute a command
+ * after the filesystem is replaced, moves the working directories that no
+ * longer exist back to /home (or / if that is gone too)
  */
-void process_command(char *input, vect_t *args_vector) {
-    if (!input || strlen(input) == 0) {
-        return;
+static void fix_directories(shell_session_t* session) {
+    work_dir_t* dirs[] = {&session->current_dir, &session->previous_dir};
+    for (int i = 0; i < 2; i++) {
+        if (!work_dir_entry(dirs[i])) {
+            fs_entry_t* home = find_fs_entry("/home");
+            strcpy(dirs[i]->path, home && home->is_dir ? "/home" : "/");
+        }
     }
+}
 
-    // Initialize virtual filesystem if needed
-    init_fs();
+int shell_restore(shell_session_t* session, const void* image, size_t size) {
+    shell_session_t* previous = shell_session_use(session);
+    int result = snapshot_load(image, size);
+    int saved_errno = errno;
+    init_fs(session);
+    fix_directories(session);
+    shell_session_use(previous);
+    errno = saved_errno;
+    return result;
+}
 
-    // Tokenize input if args_vector is empty
-    bool should_delete_vector = false;
-    if (vect_size(args_vector) == 0) {
-        args_vector = tokenize_input(input);
-        should_delete_vector = true;
+int shell_replay_journal(shell_session_t* session, const char* data, size_t len) {
+    shell_session_t* previous = shell_session_use(session);
+    int result = journal_replay(data, len);
+    int saved_errno = errno;
+    init_fs(session);
+    fix_directories(session);
+    shell_session_use(previous);
+    errno = saved_errno;
+    return result;
+}
+
+int shell_save_file(shell_session_t* session, const char* path) {
+    shell_session_t* previous = shell_session_use(session);
+    int result = snapshot_save_file(path);
+    shell_session_use(previous);
+    return result;
+}
+
+int shell_load_file(shell_session_t* session, const char* path) {
+    shell_session_t* previous = shell_session_use(session);
+    int result = snapshot_load_file(path);
+    int saved_errno = errno;
+    // A failed load may leave an empty filesystem
+    init_fs(session);
+    fix_directories(session);
+    shell_session_use(previous);
+    errno = saved_errno;
+    return result;
+}
+
+int cmd_help(shell_session_t* session, int argc, const char** argv);
+
+int cmd_source(shell_session_t* session, int argc, const char** argv);
+
+int cmd_stats(shell_session_t* session, int argc, const char** argv);
+
+int cmd_time(shell_session_t* session, int argc, const char** argv);
+
+int cmd_exit(shell_session_t* session, int argc, const char** argv) {
+    return SHELL_STATUS_EXIT;
+}
+
+/**
+ * Registry of built-in commands. Dispatch, arity checks and the help text
+ * are all driven by this table; add new builtins here. Builtins that
+ * consume input are filters and have no handler, except cat: it runs its
+ * handler when given files and its filter when it reads its input.
+ */
+typedef struct {
+    const char* name;
+    int (*handler)(shell_session_t* session, int argc, const char** argv);
+    int min_args;           // operands required, not counting the name
+    int max_args;           // operands allowed, or -1 for any number
+    const char* synopsis;
+    const char* description;
+    const char* usage;
+    const filter_t* filter;
+} builtin_t;
+
+static const builtin_t builtins[] = {
+    {"ls", cmd_ls, 0, -1, "ls [-l]",
+        "List files in the current directory.",
+        "-l: show in long format with details"},
+    {"cd", cmd_cd, 1, 1, "cd <directory>",
+        "Change the current directory.",
+        "Usage: cd <path> or cd - for previous directory"},
+    {"pwd", cmd_pwd, 0, 0, "pwd",
+        "Print working directory.",
+        "Usage: pwd"},
+    {"echo", cmd_echo, 0, -1, "echo <text>",
+        "Print text to the terminal.",
+        "Usage: echo Hello World"},
+    {"cat", cmd_cat, 0, -1, "cat [file]...",
+        "Display contents of files, or of its input without any.",
+        "Usage: cat file.txt or ls | cat",
+        &cat_filter},
+    {"touch", cmd_touch, 1, -1, "touch <file>...",
+        "Create new empty files or update their modification time.",
+        "Usage: touch file.txt"},
+    {"mkdir", cmd_mkdir, 1, -1, "mkdir <directory>...",
+        "Create new directories.",
+        "Usage: mkdir mydir"},
+    {"rm", cmd_rm, 1, -1, "rm [-r] <file/directory>...",
+        "Remove files or directories.",
+        "-r: remove directories and their contents recursively\n"
+        "Usage: rm file.txt or rm -r mydir"},
+    {"cp", cmd_cp, 2, -1, "cp [-r] <source>... <destination>",
+        "Copy files, or directories with -r. Copies share their content until one is changed.",
+        "Usage: cp notes.txt backup.txt or cp -r mydir backup"},
+    {"mv", cmd_mv, 2, -1, "mv <source>... <destination>",
+        "Move or rename files and directories.",
+        "Usage: mv old.txt new.txt or mv a.txt b.txt mydir"},
+    {"grep", NULL, 1, -1, "grep [-vicn] <pattern> [file]...",
+        "Print the lines that contain the pattern.",
+        "-v: print the lines that do not match\n"
+        "-i: ignore case\n"
+        "-c: print only the number of matching lines\n"
+        "-n: prefix each line with its line number\n"
+        "Usage: ls | grep md",
+        &grep_filter},
+    {"wc", NULL, 0, -1, "wc [-lwc] [file]...",
+        "Count lines, words and bytes.",
+        "-l: lines, -w: words, -c: bytes\n"
+        "Usage: cat README.md | wc -l",
+        &wc_filter},
+    {"head", NULL, 0, -1, "head [-n N] [file]...",
+        "Print the first N lines (10 by default).",
+        "Usage: cat README.md | head -n 5",
+        &head_filter},
+    {"tail", NULL, 0, -1, "tail [-n N] [file]...",
+        "Print the last N lines (10 by default).",
+        "Usage: cat README.md | tail -n 5",
+        &tail_filter},
+    {"sort", NULL, 0, -1, "sort [-rn] [file]...",
+        "Print lines in sorted order.",
+        "-r: reverse the order\n"
+        "-n: compare numerically\n"
+        "Usage: ls | sort -r",
+        &sort_filter},
+    {"uniq", NULL, 0, -1, "uniq [-c] [file]...",
+        "Collapse adjacent repeated lines.",
+        "-c: prefix each line with its number of repeats\n"
+        "Usage: sort names | uniq -c",
+        &uniq_filter},
+    {"source", cmd_source, 1, 1, "source <file>",
+        "Run the commands in a file, one per line or separated by ';'.",
+        "Lines starting with '#' are comments\n"
+        "Usage: source setup.sh"},
+    {"stats", cmd_stats, 0, 1, "stats [-j]",
+        "Show the calls, latency, output and allocations of each command.",
+        "A pipeline counts as a whole, under the names of its commands\n"
+        "-j: print the numbers as JSON\n"
+        "Usage: stats"},
+    {"time", cmd_time, 1, -1, "time <command>",
+        "Run a command or pipeline and report what it cost.",
+        "Usage: time cat README.md | wc -l"},
+    {"date", cmd_date, 0, 0, "date",
+        "Display current date and time.",
+        "Usage: date"},
+    {"whoami", cmd_whoami, 0, 0, "whoami",
+        "Display current user.",
+        "Usage: whoami"},
+    {"clear", cmd_clear, 0, 0, "clear",
+        "Clear the terminal screen.",
+        "Usage: clear"},
+    {"readme", cmd_readme, 0, 0, "readme",
+        "Show the list of commands from the README.",
+        "Usage: readme"},
+    {"help", cmd_help, 0, 0, "help",
+        "Display this help information.",
+        "Usage: help"},
+    {"exit", cmd_exit, 0, 0, "exit",
+        "Exit the shell.",
+        "Usage: exit"},
+};
+
+#define NUM_BUILTINS (sizeof(builtins) / sizeof(builtins[0]))
+
+/**
+ * Perfect hash over the builtin names: builtin_table_init searches for a
+ * seed under which every name lands in its own slot, so a lookup is one
+ * hash, one slot load and one memcmp no matter how many builtins exist.
+ */
+static unsigned char builtin_slots[1024];   // builtin index + 1, 0 = empty
+static unsigned char builtin_name_len[NUM_BUILTINS];
+static unsigned int builtin_mask = 0;
+static unsigned int builtin_seed = 0;
+static pthread_once_t builtin_table_once = PTHREAD_ONCE_INIT;
+
+static unsigned int builtin_hash(const char* name, size_t len, unsigned int seed) {
+    unsigned int hash = 2166136261u ^ seed;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (unsigned char)name[i];
+        hash *= 16777619u;
+    }
+    return hash ^ (hash >> 15);
+}
+
+static void builtin_table_init(void) {
+    unsigned int size = 4;
+    while (size < 4 * NUM_BUILTINS) {
+        size *= 2;
+    }
+    for (size_t i = 0; i < NUM_BUILTINS; i++) {
+        builtin_name_len[i] = strlen(builtins[i].name);
     }
 
-    if (vect_size(args_vector) == 0) {
-        if (should_delete_vector) {
-            vect_delete(args_vector);
+    for (; size <= sizeof(builtin_slots); size *= 2) {
+        for (unsigned int seed = 1; seed <= 100000; seed++) {
+            bool collision = false;
+            memset(builtin_slots, 0, size);
+            for (size_t i = 0; i < NUM_BUILTINS && !collision; i++) {
+                unsigned int slot = builtin_hash(builtins[i].name, builtin_name_len[i], seed) & (size - 1);
+                collision = builtin_slots[slot] != 0;
+                builtin_slots[slot] = i + 1;
+            }
+            if (!collision) {
+                builtin_seed = seed;
+                builtin_mask = size - 1;
+                return;
+            }
         }
-        return;
+        // No perfect seed at this size; try a sparser table
     }
+    assert(!"no perfect hash seed for the builtin table");
+}
 
-    const char *command = vect_get(args_vector, 0);
+/** Find the builtin with the given name, or NULL. */
+static const builtin_t* find_builtin(const char* name) {
+    pthread_once(&builtin_table_once, builtin_table_init);
+    size_t len = strlen(name);
+    unsigned int slot = builtin_hash(name, len, builtin_seed) & builtin_mask;
+    int idx = builtin_slots[slot] - 1;
+    if (idx < 0 || builtin_name_len[idx] != len || memcmp(builtins[idx].name, name, len) != 0) {
+        return NULL;
+    }
+    return &builtins[idx];
+}
 
-    if (strcmp(command, "help") == 0) {
-        print_help();
-    } else if (strcmp(command, "cd") == 0) {
-        if (vect_size(args_vector) > 1) {
-            cmd_cd(vect_get(args_vector, 1));
-        } else {
-            custom_printf("cd: missing argument\n");
-        }
-    } else if (strcmp(command, "pwd") == 0) {
-        cmd_pwd();
-    } else if (strcmp(command, "ls") == 0) {
-        cmd_ls(args_vector);
-    } else if (strcmp(command, "echo") == 0) {
-        cmd_echo(args_vector);
-    } else if (strcmp(command, "cat") == 0) {
-        if (vect_size(args_vector) > 1) {
-            cmd_cat(vect_get(args_vector, 1));
-        } else {
-            custom_printf("cat: missing file operand\n");
+/**
+ * Function which prints the help information
+ */
+void print_help() {
+    custom_printf("Built-in commands:\n");
+    for (size_t i = 0; i < NUM_BUILTINS; i++) {
+        const builtin_t* builtin = &builtins[i];
+        char number[16];
+        int width = snprintf(number, sizeof(number), "%zu. ", i + 1);
+
+        custom_printf("%s%s\n", number, builtin->synopsis);
+        custom_printf("%*s%s\n", width, "", builtin->description);
+
+        // Indent every line of the usage text under the synopsis
+        const char* line = builtin->usage;
+        while (*line) {
+            const char* end = strchr(line, '\n');
+            int len = end ? (int)(end - line) : (int)strlen(line);
+            custom_printf("%*s%.*s\n", width, "", len, line);
+            line += len + (end ? 1 : 0);
         }
-    } else if (strcmp(command, "touch") == 0) {
-        if (vect_size(args_vector) > 1) {
-            cmd_touch(vect_get(args_vector, 1));
-        } else {
-            custom_printf("touch: missing file operand\n");
+        if (i < NUM_BUILTINS - 1) {
+            custom_printf("\n");
+        }
+    }
+}
+
+int cmd_help(shell_session_t* session, int argc, const char** argv) {
+    print_help();
+    return 0;
+}
+
+/**
+ * Look up a command's builtin and check its arity, printing the error if
+ * either fails. Returns the builtin, or NULL with *status set.
+ */
+static const builtin_t* resolve_command(const command_t* command, int* status) {
+    const builtin_t* builtin = find_builtin(command->argv[0]);
+    if (!builtin) {
+        custom_printf("Unknown command: %s\n", command->argv[0]);
+        custom_printf("Type 'help' for a list of commands\n");
+        *status = SHELL_STATUS_NOT_FOUND;
+    } else if (command->argc - 1 < builtin->min_args) {
+        custom_printf("%s: missing operand\n", builtin->name);
+        custom_printf("Usage: %s\n", builtin->synopsis);
+        *status = SHELL_STATUS_ERROR;
+        builtin = NULL;
+    } else if (builtin->max_args >= 0 && command->argc - 1 > builtin->max_args) {
+        custom_printf("%s: too many arguments\n", builtin->name);
+        custom_printf("Usage: %s\n", builtin->synopsis);
+        *status = SHELL_STATUS_ERROR;
+        builtin = NULL;
+    }
+    return builtin;
+}
+
+/** Does a command run its builtin's handler rather than its filter? */
+static bool runs_handler(const builtin_t* builtin, const command_t* command) {
+    return !builtin->filter || (builtin->handler && command->argc > 1);
+}
+
+/**
+ * Allocate a filter's state and parse its options. Returns the state and
+ * sets *first to the index of the first file operand, or returns NULL.
+ */
+static void* begin_filter(shell_session_t* session, const filter_t* filter, const command_t* command,
+                          int* first) {
+    void* state = arena_alloc(&session->command_arena, filter->state_size);
+    if (!state) {
+        custom_printf("shell: out of memory\n");
+        return NULL;
+    }
+    memset(state, 0, filter->state_size);
+    *first = filter->begin(state, &session->command_arena, command->argc, command->argv);
+    return *first < 0 ? NULL : state;
+}
+
+/**
+ * Run a filter over the files from argv[first] on, writing to the current
+ * sink. Without file operands the filter reads input (the '<' file), or
+ * sees no input if that is NULL.
+ */
+static int filter_files(shell_session_t* session, const filter_t* filter, void* state,
+                        const command_t* command, int first, const fs_entry_t* input) {
+    line_stream_t stream;
+    int status = 0;
+
+    line_stream_init(&stream, filter, state, output_sink(), &session->command_arena);
+    if (first == command->argc && input && input->size > 0) {
+        stream.sink.write(&stream.sink, input->content, input->size);
+    }
+    for (int i = first; i < command->argc; i++) {
+        const char* filename = command->argv[i];
+        fs_entry_t* entry = resolve_path(session, filename);
+        if (!entry || entry->is_dir) {
+            custom_printf("%s: %s: No such file\n", command->argv[0], filename);
+            status = SHELL_STATUS_ERROR;
+        } else if (entry->size > 0 && !stream.sink.closed) {
+            stream.sink.write(&stream.sink, entry->content, entry->size);
+        }
+    }
+    int result = line_stream_finish(&stream);
+    return status ? status : result;
+}
+
+/** Run a single command with its output going to the current sink and
+ *  input (NULL for none) as the input of a filter. */
+static int run_command(shell_session_t* session, const command_t* command, const fs_entry_t* input) {
+    if (command->argc == 0) {
+        return SHELL_STATUS_OK;     // only redirections
+    }
+
+    int status;
+    const builtin_t* builtin = resolve_command(command, &status);
+    if (!builtin) {
+        return status;
+    }
+    if (runs_handler(builtin, command)) {
+        return builtin->handler(session, command->argc, command->argv);
+    }
+
+    int first;
+    void* state = begin_filter(session, builtin->filter, command, &first);
+    if (!state) {
+        return SHELL_STATUS_ERROR;
+    }
+    return filter_files(session, builtin->filter, state, command, first, input);
+}
+
+/**
+ * Prepare pipeline stage command, whose output goes to downstream (also
+ * the current sink). A filter reading its input gets *stream; any other
+ * stage runs right away. Returns the stage's status so far.
+ */
+static int setup_stage(shell_session_t* session, const command_t* command, out_sink_t* downstream,
+                       line_stream_t** stream) {
+    if (command->argc == 0) {
+        return SHELL_STATUS_OK;
+    }
+
+    int status;
+    const builtin_t* builtin = resolve_command(command, &status);
+    if (!builtin) {
+        return status;
+    }
+    if (runs_handler(builtin, command)) {
+        return builtin->handler(session, command->argc, command->argv);
+    }
+
+    int first;
+    void* state = begin_filter(session, builtin->filter, command, &first);
+    if (!state) {
+        return SHELL_STATUS_ERROR;
+    }
+    if (first < command->argc) {
+        return filter_files(session, builtin->filter, state, command, first, NULL);
+    }
+    *stream = arena_alloc(&session->command_arena, sizeof(line_stream_t));
+    if (!*stream) {
+        custom_printf("shell: out of memory\n");
+        return SHELL_STATUS_ERROR;
+    }
+    line_stream_init(*stream, builtin->filter, state, downstream, &session->command_arena);
+    return SHELL_STATUS_OK;
+}
+
+static int discard_write(out_sink_t* sink, const char* data, size_t len) {
+    return -1;
+}
+
+// Input of a stage that does not read it
+static out_sink_t discard_sink = {discard_write, true};
+
+/**
+ * Sink for '>' and '>>': appends to a file of the virtual filesystem, so
+ * output streams straight into the file's content and a series of
+ * appends grows it geometrically instead of rewriting it. The file is
+ * resolved once and watched (see vfs_watch), so a write costs the same
+ * however deep the file lies.
+ */
+typedef struct file_sink file_sink_t;
+struct file_sink {
+    out_sink_t sink;        // must be first
+    fs_entry_t* entry;      // NULL once the command removes the file
+    file_sink_t* next;      // opened before this one, see open_output
+};
+
+static int file_sink_write(out_sink_t* sink, const char* data, size_t len) {
+    file_sink_t* file = (file_sink_t*)sink;
+
+    // Output to a removed file is dropped
+    if (!file->entry || fs_append_content(file->entry, data, len) != 0) {
+        sink->closed = true;
+        return -1;
+    }
+    return 0;
+}
+
+/** Open the output file of a command, creating it, or truncating it for
+ *  '>'. Returns its sink, or NULL after printing the error. The sink stays
+ *  watched until close_outputs. */
+static out_sink_t* open_output(shell_session_t* session, const command_t* command) {
+    fs_entry_t* entry = resolve_path(session, command->output_file);
+    if (!entry && !(entry = create_path(session, command->output_file, false))) {
+        custom_printf("shell: %s: %s\n", command->output_file, strerror(errno));
+        return NULL;
+    }
+    if (entry->is_dir) {
+        custom_printf("shell: %s: Is a directory\n", command->output_file);
+        return NULL;
+    }
+    if (!command->append) {
+        fs_set_content(entry, NULL, 0);
+    }
+    fs_touch(entry, time(NULL));
+
+    file_sink_t* file = arena_alloc(&session->command_arena, sizeof(file_sink_t));
+    if (!file) {
+        custom_printf("shell: out of memory\n");
+        return NULL;
+    }
+    file->entry = entry;
+    if (vfs_watch(session->fs, &file->entry) != 0) {
+        custom_printf("shell: %s: Too many open files\n", command->output_file);
+        return NULL;
+    }
+    file->next = session->open_files;
+    session->open_files = file;
+    file->sink.write = file_sink_write;
+    file->sink.closed = false;
+    return &file->sink;
+}
+
+/** Stop watching the files opened since `until` was the newest, before
+ *  their sinks go with the command arena. */
+static void close_outputs(shell_session_t* session, file_sink_t* until) {
+    while (session->open_files != until) {
+        vfs_unwatch(session->fs, &session->open_files->entry);
+        session->open_files = session->open_files->next;
+    }
+}
+
+/** Find the input file of a command. Returns it, or NULL after printing
+ *  the error. */
+static const fs_entry_t* open_input(shell_session_t* session, const command_t* command) {
+    fs_entry_t* entry = resolve_path(session, command->input_file);
+    if (!entry || entry->is_dir) {
+        custom_printf("shell: %s: No such file\n", command->input_file);
+        return NULL;
+    }
+    return entry;
+}
+
+/**
+ * The command with its patterns expanded, in the command arena: each word
+ * that is a pattern is replaced by the paths it matches in sorted order,
+ * or kept as it is if it matches none (see glob_expand). This runs before
+ * every dispatch, since the parse of a line is cached while the files
+ * change. Returns the command itself if it has no patterns, or NULL if
+ * memory is exhausted.
+ */
+static const command_t* expand_command(shell_session_t* session, const command_t* command) {
+    if (!command->patterns) {
+        return command;
+    }
+    arena_t* arena = &session->command_arena;
+    fs_entry_t* cwd = work_dir_entry(&session->current_dir);
+    glob_list_t words = {0};
+    for (int i = 0; i < command->argc; i++) {
+        int found = 0;
+        if (command->patterns[i]) {
+            found = glob_expand(&session->globs, arena, cwd, command->argv[i], &words);
         }
-    } else if (strcmp(command, "mkdir") == 0) {
-        if (vect_size(args_vector) > 1) {
-            cmd_mkdir(vect_get(args_vector, 1));
+        if (found < 0 || (found == 0 && glob_list_add(arena, &words, command->argv[i]) != 0)) {
+            return NULL;
+        }
+    }
+    command_t* expanded = arena_alloc(arena, sizeof(command_t));
+    if (!expanded || glob_list_add(arena, &words, NULL) != 0) {
+        return NULL;
+    }
+    *expanded = *command;
+    expanded->argc = words.count - 1;
+    expanded->argv = words.words;
+    expanded->patterns = NULL;
+    return expanded;
+}
+
+/**
+ * Run the commands of a pipeline, each stage's output streaming line by
+ * line into the filter of the next. Nothing is materialized between the
+ * stages: once a stage stops reading (head has its lines), the sinks
+ * upstream close and the producer stops early.
+ *
+ * Stages are set up from the last to the first, so every stream exists
+ * before anything writes into it. A stage that does not read the pipe
+ * (not a filter, a filter given files, or one with '<') runs during
+ * setup, and the stage before it writes into a closed sink. A stage with
+ * '>' writes to its file, and the next stage reads nothing.
+ */
+static int run_pipeline(shell_session_t* session, const pipeline_t* pipeline) {
+    int n = pipeline->count;
+
+    // streams[k] feeds stage k; NULL where stage k does not read the pipe
+    line_stream_t** streams = arena_alloc(&session->command_arena, n * sizeof(line_stream_t*));
+    int* statuses = arena_alloc(&session->command_arena, n * sizeof(int));
+    if (!streams || !statuses) {
+        custom_printf("shell: out of memory\n");
+        return SHELL_STATUS_ERROR;
+    }
+
+    out_sink_t* output = output_sink();
+    file_sink_t* files = session->open_files;
+    for (int k = n - 1; k >= 0; k--) {
+        const command_t* command = expand_command(session, &pipeline->commands[k]);
+        if (!command) {
+            custom_printf("shell: out of memory\n");
+            statuses[k] = SHELL_STATUS_ERROR;
+            streams[k] = NULL;
+            continue;
+        }
+        out_sink_t* downstream = k == n - 1 ? output
+            : streams[k + 1] ? &streams[k + 1]->sink : &discard_sink;
+        out_sink_t* previous = output_set_sink(downstream);
+        const fs_entry_t* input = NULL;
+
+        streams[k] = NULL;
+        if (command->output_file && !(downstream = open_output(session, command))) {
+            statuses[k] = SHELL_STATUS_ERROR;
+        } else if (command->input_file && !(input = open_input(session, command))) {
+            statuses[k] = SHELL_STATUS_ERROR;
         } else {
-            custom_printf("mkdir: missing operand\n");
+            output_set_sink(downstream);
+            if (k == 0 || input) {
+                statuses[k] = run_command(session, command, input);
+            } else {
+                statuses[k] = setup_stage(session, command, downstream, &streams[k]);
+            }
+        }
+        output_set_sink(previous);
+    }
+
+    // Flush the filters in order, so each one's end still reaches the next
+    for (int k = 1; k < n; k++) {
+        if (streams[k]) {
+            statuses[k] = line_stream_finish(streams[k]);
+        }
+    }
+    close_outputs(session, files);
+    return statuses[n - 1];
+}
+
+/** The pipeline without its `time` prefix, copied into the command arena,
+ *  or NULL if it has none or memory is exhausted. */
+static const pipeline_t* strip_time(shell_session_t* session, const pipeline_t* pipeline) {
+    const command_t* first = &pipeline->commands[0];
+    if (first->argc < 2 || strcmp(first->argv[0], "time") != 0) {
+        return NULL;
+    }
+    pipeline_t* stripped = arena_alloc(&session->command_arena, sizeof(pipeline_t));
+    command_t* commands = arena_alloc(&session->command_arena, pipeline->count * sizeof(command_t));
+    if (!stripped || !commands) {
+        return NULL;
+    }
+    memcpy(commands, pipeline->commands, pipeline->count * sizeof(command_t));
+    commands[0].argc--;
+    commands[0].argv++;
+    if (commands[0].patterns) {
+        commands[0].patterns++;
+    }
+    stripped->count = pipeline->count;
+    stripped->commands = commands;
+    return stripped;
+}
+
+/**
+ * The counters of a pipeline: those of its builtin for a single command,
+ * or for several, those kept under the names of all of them, so "cat
+ * README.md | wc" is not charged to cat alone. NULL if a command is not a
+ * builtin or memory is exhausted.
+ */
+static stats_counter_t* pipeline_counter(shell_session_t* session, const pipeline_t* pipeline) {
+    const builtin_t* builtin = NULL;
+    size_t len = 0;
+    for (int k = 0; k < pipeline->count; k++) {
+        const command_t* command = &pipeline->commands[k];
+        if (command->argc == 0 || !(builtin = find_builtin(command->argv[0]))) {
+            return NULL;
+        }
+        len += strlen(builtin->name) + 3;
+    }
+    if (pipeline->count == 1) {
+        if (!session->stats && !(session->stats = calloc(NUM_BUILTINS, sizeof(stats_counter_t)))) {
+            return NULL;
         }
-    } else if (strcmp(command, "rm") == 0) {
-        if (vect_size(args_vector) > 1) {
-            cmd_rm(vect_get(args_vector, 1));
+        return &session->stats[builtin - builtins];
+    }
+
+    char* name = arena_alloc(&session->command_arena, len);
+    if (!name) {
+        return NULL;
+    }
+    char* cursor = name;
+    for (int k = 0; k < pipeline->count; k++) {
+        cursor += sprintf(cursor, k ? " | %s" : "%s", pipeline->commands[k].argv[0]);
+    }
+    for (size_t i = 0; i < session->pipeline_stats_count; i++) {
+        if (strcmp(session->pipeline_stats[i].name, name) == 0) {
+            return &session->pipeline_stats[i].counter;
+        }
+    }
+
+    size_t count = session->pipeline_stats_count;
+    pipeline_stats_t* all = realloc(session->pipeline_stats, (count + 1) * sizeof(pipeline_stats_t));
+    if (!all) {
+        return NULL;
+    }
+    session->pipeline_stats = all;
+    if (!(all[count].name = malloc(cursor - name + 1))) {
+        return NULL;
+    }
+    memcpy(all[count].name, name, cursor - name + 1);
+    memset(&all[count].counter, 0, sizeof(stats_counter_t));
+    session->pipeline_stats_count++;
+    return &all[count].counter;
+}
+
+/**
+ * Run a pipeline and add what it cost to its counters (see
+ * pipeline_counter). With a `time` prefix, also report the cost after its
+ * output, to where the output of the whole pipeline would go without
+ * redirection.
+ */
+static int run_measured(shell_session_t* session, const pipeline_t* pipeline) {
+    const pipeline_t* timed = strip_time(session, pipeline);
+    if (timed) {
+        pipeline = timed;
+    }
+
+    stats_sample_t sample;
+    stats_begin(&sample);
+    int status = run_pipeline(session, pipeline);
+    stats_end(&sample);
+
+    stats_counter_t* counter = pipeline_counter(session, pipeline);
+    if (counter) {
+        stats_add(counter, &sample, status);
+    }
+    if (timed) {
+        custom_printf("real    %.3f ms\n", sample.ns / 1e6);
+        custom_printf("output  %llu bytes\n", (unsigned long long)sample.bytes);
+        custom_printf("allocs  %llu\n", (unsigned long long)sample.allocs);
+    }
+    return status;
+}
+
+/** Run the pipelines of a list in order, stopping early only for exit.
+ *  Returns the status of the last one run. */
+static int run_command_list(shell_session_t* session, const command_list_t* list) {
+    int status = SHELL_STATUS_OK;
+    for (int i = 0; i < list->count && status != SHELL_STATUS_EXIT; i++) {
+        arena_mark_t mark = arena_mark(&session->command_arena);
+        status = run_measured(session, &list->pipelines[i]);
+        arena_rewind(&session->command_arena, mark);
+    }
+    return status;
+}
+
+int cmd_time(shell_session_t* session, int argc, const char** argv) {
+    // A leading `time` is taken off by run_measured, so this is one
+    // further down a pipeline
+    custom_printf("time: must start a pipeline\n");
+    return SHELL_STATUS_ERROR;
+}
+
+int shell_stats_json(shell_session_t* session, out_buf_t* b) {
+    unsigned long hits, misses;
+    bool first = true;
+
+    shell_line_cache_stats(session, &hits, &misses);
+    if (out_buf_write(b, "{\"commands\": [", 14) < 0) {
+        return -1;
+    }
+    for (size_t i = 0; session->stats && i < NUM_BUILTINS; i++) {
+        if (session->stats[i].calls == 0) {
+            continue;
+        }
+        if ((!first && out_buf_write(b, ", ", 2) < 0) ||
+            stats_write_json(b, builtins[i].name, &session->stats[i]) != 0) {
+            return -1;
+        }
+        first = false;
+    }
+    for (size_t i = 0; i < session->pipeline_stats_count; i++) {
+        const pipeline_stats_t* entry = &session->pipeline_stats[i];
+        if ((!first && out_buf_write(b, ", ", 2) < 0) ||
+            stats_write_json(b, entry->name, &entry->counter) != 0) {
+            return -1;
+        }
+        first = false;
+    }
+    char tail[128];
+    int len = snprintf(tail, sizeof(tail), "], \"line_cache\": {\"hits\": %lu, \"misses\": %lu}}",
+                       hits, misses);
+    return out_buf_write(b, tail, len) < 0 ? -1 : 0;
+}
+
+int cmd_stats(shell_session_t* session, int argc, const char** argv) {
+    if (argc == 2 && strcmp(argv[1], "-j") == 0) {
+        out_buf_t json = {0};
+        int result = shell_stats_json(session, &json);
+        if (result == 0) {
+            output_write(json.data, json.len);
+            output_write("\n", 1);
         } else {
-            custom_printf("rm: missing operand\n");
-        }
-    } else if (strcmp(command, "date") == 0) {
-        cmd_date();
-    } else if (strcmp(command, "whoami") == 0) {
-        cmd_whoami();
-    } else if (strcmp(command, "clear") == 0) {
-        cmd_clear();
-    } else if (strcmp(command, "readme") == 0) {
-        cmd_readme();
-    } else if (strcmp(command, "exit") == 0) {
+            custom_printf("stats: out of memory\n");
+        }
+        free(json.data);
+        return result == 0 ? SHELL_STATUS_OK : SHELL_STATUS_ERROR;
+    }
+    if (argc == 2) {
+        custom_printf("stats: invalid option '%s'\n", argv[1]);
+        custom_printf("Usage: stats [-j]\n");
+        return SHELL_STATUS_ERROR;
+    }
+
+    unsigned long hits, misses;
+    shell_line_cache_stats(session, &hits, &misses);
+    stats_print_header();
+    for (size_t i = 0; session->stats && i < NUM_BUILTINS; i++) {
+        if (session->stats[i].calls > 0) {
+            stats_print_row(builtins[i].name, &session->stats[i]);
+        }
+    }
+    for (size_t i = 0; i < session->pipeline_stats_count; i++) {
+        stats_print_row(session->pipeline_stats[i].name, &session->pipeline_stats[i].counter);
+    }
+    custom_printf("line cache: %lu hits, %lu misses\n", hits, misses);
+    return SHELL_STATUS_OK;
+}
+
+#define SCRIPT_CACHE_SIZE 16
+#define SOURCE_MAX_DEPTH 32
+
+/**
+ * Parsed scripts, keyed by file identity and version, so sourcing an
+ * unchanged script again goes straight to execution. Each script owns an
+ * arena; the least recently used one is evicted. Scripts being run are
+ * pinned, since a script may source others.
+ */
+typedef struct {
+    unsigned long ino;          // 0 = empty slot
+    unsigned long version;
+    unsigned long last_used;
+    unsigned int busy;
+    arena_t arena;
+    command_list_t list;
+} script_t;
+
+struct script_cache {
+    script_t scripts[SCRIPT_CACHE_SIZE];
+    unsigned long clock;
+};
+
+/**
+ * Parse a script's content into list, line by line, skipping blank lines
+ * and comments. Returns 0, or -1 after printing the error.
+ */
+static int parse_script(shell_session_t* session, arena_t* arena, const char* filename,
+                        const fs_entry_t* entry, command_list_t* list) {
+    const char* content = fs_entry_content(entry);
+    const char* end = content + entry->size;
+    int line_number = 0;
+
+    memset(list, 0, sizeof(*list));
+    for (const char* line = content; line < end; ) {
+        const char* newline = memchr(line, '\n', end - line);
+        size_t len = newline ? (size_t)(newline - line) : (size_t)(end - line);
+        line_number++;
+
+        // The tokenizer wants a NUL-terminated line; copy it to scratch
+        arena_mark_t mark = arena_mark(&session->command_arena);
+        char* text = arena_strndup(&session->command_arena, line, len);
+        int result = text ? 0 : -1;
+        if (text && text[strspn(text, " \t")] != '#') {
+            result = parse_line(arena, text, list);
+        }
+        arena_rewind(&session->command_arena, mark);
+
+        if (result < 0) {
+            custom_printf("source: out of memory\n");
+            return -1;
+        }
+        if (result > 0) {
+            custom_printf("source: %s: line %d: syntax error near unexpected token `%s'\n",
+                filename, line_number, list->unexpected);
+            return -1;
+        }
+        line = line + len + 1;
+    }
+    return 0;
+}
+
+/**
+ * Find the parsed form of a script, parsing it on a miss. Returns the
+ * pinned cache slot, or NULL after printing the error.
+ */
+static script_t* load_script(shell_session_t* session, const char* filename, const fs_entry_t* entry) {
+    struct script_cache* cache = session->scripts;
+    if (!cache && !(cache = session->scripts = calloc(1, sizeof(struct script_cache)))) {
+        custom_printf("source: out of memory\n");
+        return NULL;
+    }
+
+    script_t* victim = NULL;
+    for (int i = 0; i < SCRIPT_CACHE_SIZE; i++) {
+        script_t* script = &cache->scripts[i];
+        if (script->ino == entry->ino && script->version == entry->version) {
+            script->last_used = ++cache->clock;
+            script->busy++;
+            return script;
+        }
+        if (!script->busy && (!victim || script->last_used < victim->last_used)) {
+            victim = script;
+        }
+    }
+    // Every slot is running a script; source depth bounds this to
+    // SOURCE_MAX_DEPTH, so it only happens for deep nesting
+    if (!victim) {
+        custom_printf("source: %s: too many scripts running\n", filename);
+        return NULL;
+    }
+
+    arena_reset(&victim->arena);
+    victim->ino = 0;
+    if (parse_script(session, &victim->arena, filename, entry, &victim->list) != 0) {
+        return NULL;
+    }
+    victim->ino = entry->ino;
+    victim->version = entry->version;
+    victim->last_used = ++cache->clock;
+    victim->busy = 1;
+    return victim;
+}
+
+int cmd_source(shell_session_t* session, int argc, const char** argv) {
+    fs_entry_t* entry = resolve_path(session, argv[1]);
+    if (!entry || entry->is_dir) {
+        custom_printf("source: %s: No such file\n", argv[1]);
+        return SHELL_STATUS_ERROR;
+    }
+    if (session->source_depth >= SOURCE_MAX_DEPTH) {
+        custom_printf("source: %s: maximum nesting depth exceeded\n", argv[1]);
+        return SHELL_STATUS_ERROR;
+    }
+
+    script_t* script = load_script(session, argv[1], entry);
+    if (!script) {
+        return SHELL_STATUS_ERROR;
+    }
+    session->source_depth++;
+    int status = run_command_list(session, &script->list);
+    session->source_depth--;
+    script->busy--;
+    return status;
+}
+
+#define LINE_CACHE_SIZE 64
+
+/**
+ * Recently run command lines in their parsed form, so a repeated command
+ * (ls -l, pwd, a prompt refresh) skips tokenizing and allocation. Each
+ * entry is one read-only block holding the command list, its argv
+ * arrays, the strings and the raw line the key was hashed from; the hashes
+ * sit in their own array so a lookup scans 256 bytes. The least recently
+ * used entry is evicted.
+ */
+typedef struct {
+    char* block;                // NULL = empty slot
+    size_t size;
+    const char* input;          // the raw line, inside block
+    size_t len;                 // its length
+    unsigned long last_used;
+} cached_line_t;
+
+struct line_cache {
+    unsigned int hash[LINE_CACHE_SIZE];
+    cached_line_t lines[LINE_CACHE_SIZE];
+    unsigned long clock;
+};
+
+static unsigned int line_hash(const char* input, size_t len) {
+    unsigned int hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (unsigned char)input[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/** The cached parse of input, or NULL. */
+static const command_list_t* line_cache_find(shell_session_t* session, const char* input, size_t len,
+                                             unsigned int hash) {
+    struct line_cache* cache = session->lines;
+    for (int i = 0; cache && i < LINE_CACHE_SIZE; i++) {
+        if (cache->hash[i] == hash && cache->lines[i].block && cache->lines[i].len == len &&
+            memcmp(cache->lines[i].input, input, len) == 0) {
+            cache->lines[i].last_used = ++cache->clock;
+            return (const command_list_t*)cache->lines[i].block;
+        }
+    }
+    return NULL;
+}
+
+/** Copy s to the string area at *cursor. */
+static const char* copy_string(char** cursor, const char* s) {
+    if (!s) {
+        return NULL;
+    }
+    size_t len = strlen(s) + 1;
+    char* copy = memcpy(*cursor, s, len);
+    *cursor += len;
+    return copy;
+}
+
+/** Copy a parsed line into one block and cache it, evicting the least
+ *  recently used entry. Failing to cache is not an error. */
+static void line_cache_store(shell_session_t* session, const char* input, size_t len, unsigned int hash,
+                             const command_list_t* list) {
+    struct line_cache* cache = session->lines;
+    if (!cache && !(cache = session->lines = calloc(1, sizeof(struct line_cache)))) {
+        return;
+    }
+
+    // Size the block: pointer-aligned arrays first, then the strings
+    int commands = 0, args = 0;
+    size_t strings = len + 1;
+    for (int i = 0; i < list->count; i++) {
+        const pipeline_t* pipeline = &list->pipelines[i];
+        commands += pipeline->count;
+        for (int j = 0; j < pipeline->count; j++) {
+            const command_t* command = &pipeline->commands[j];
+            args += command->argc + 1;
+            for (int k = 0; k < command->argc; k++) {
+                strings += strlen(command->argv[k]) + 1;
+            }
+            strings += command->patterns ? command->argc : 0;
+            strings += command->input_file ? strlen(command->input_file) + 1 : 0;
+            strings += command->output_file ? strlen(command->output_file) + 1 : 0;
+        }
+    }
+    size_t size = sizeof(command_list_t) + list->count * sizeof(pipeline_t) +
+                  commands * sizeof(command_t) + args * sizeof(char*) + strings;
+    char* block = mem_pool_alloc(&session->line_pool, size);
+    if (!block) {
+        return;
+    }
+
+    command_list_t* copy = (command_list_t*)block;
+    pipeline_t* pipelines = (pipeline_t*)(copy + 1);
+    command_t* command_copy = (command_t*)(pipelines + list->count);
+    const char** argv = (const char**)(command_copy + commands);
+    char* cursor = (char*)(argv + args);
+
+    *copy = (command_list_t){list->count, list->count, pipelines, NULL};
+    for (int i = 0; i < list->count; i++) {
+        const pipeline_t* pipeline = &list->pipelines[i];
+        pipelines[i].count = pipeline->count;
+        pipelines[i].commands = command_copy;
+        for (int j = 0; j < pipeline->count; j++) {
+            const command_t* command = &pipeline->commands[j];
+            *command_copy = *command;
+            command_copy->argv = argv;
+            for (int k = 0; k < command->argc; k++) {
+                *argv++ = copy_string(&cursor, command->argv[k]);
+            }
+            *argv++ = NULL;
+            if (command->patterns) {
+                command_copy->patterns = memcpy(cursor, command->patterns, command->argc);
+                cursor += command->argc;
+            }
+            command_copy->input_file = copy_string(&cursor, command->input_file);
+            command_copy->output_file = copy_string(&cursor, command->output_file);
+            command_copy++;
+        }
+    }
+
+    cached_line_t* lines = cache->lines;
+    int victim = 0;
+    for (int i = 1; i < LINE_CACHE_SIZE && lines[victim].block; i++) {
+        if (!lines[i].block || lines[i].last_used < lines[victim].last_used) {
+            victim = i;
+        }
+    }
+    mem_pool_free(&session->line_pool, lines[victim].block, lines[victim].size);
+    lines[victim].block = block;
+    lines[victim].size = size;
+    lines[victim].input = copy_string(&cursor, input);
+    lines[victim].len = len;
+    lines[victim].last_used = ++cache->clock;
+    cache->hash[victim] = hash;
+}
+
+void shell_line_cache_stats(shell_session_t* session, unsigned long* hits, unsigned long* misses) {
+    *hits = session->line_hits;
+    *misses = session->line_misses;
+}
+
+shell_session_t* shell_session_new(void) {
+    pthread_once(&seed_image_once, seed_image_init);
+    return shell_session_new_on(seed_image);
+}
+
+shell_session_t* shell_session_new_on(const vfs_t* image) {
+    shell_session_t* session = calloc(1, sizeof(shell_session_t));
+    if (!session || !(session->fs = image ? vfs_new_overlay(image) : vfs_new())) {
+        free(session);
+        return NULL;
+    }
+    strcpy(session->current_dir.path, "/home");
+    strcpy(session->previous_dir.path, "/home");
+    vfs_watch(session->fs, &session->current_dir.entry);
+    vfs_watch(session->fs, &session->previous_dir.entry);
+    output_init(&session->output);
+    return session;
+}
+
+void shell_session_delete(shell_session_t* session) {
+    if (!session) {
         return;
+    }
+    if (current_session == session) {
+        shell_session_use(NULL);
+    }
+    if (session->lines) {
+        // Blocks above MEM_MAX_CLASS are not in the pool's slabs
+        for (int i = 0; i < LINE_CACHE_SIZE; i++) {
+            cached_line_t* line = &session->lines->lines[i];
+            mem_pool_free(&session->line_pool, line->block, line->size);
+        }
+        free(session->lines);
+    }
+    mem_pool_destroy(&session->line_pool);
+    if (session->scripts) {
+        for (int i = 0; i < SCRIPT_CACHE_SIZE; i++) {
+            arena_destroy(&session->scripts->scripts[i].arena);
+        }
+        free(session->scripts);
+    }
+    free(session->stats);
+    for (size_t i = 0; i < session->pipeline_stats_count; i++) {
+        free(session->pipeline_stats[i].name);
+    }
+    free(session->pipeline_stats);
+    glob_index_free(session->globs);
+    arena_destroy(&session->command_arena);
+    journal_destroy(&session->journal);
+    output_destroy(&session->output);
+    vfs_delete(session->fs);
+    free(session);
+}
+
+shell_session_t* shell_session_use(shell_session_t* session) {
+    shell_session_t* previous = current_session;
+    current_session = session;
+    vfs_use(session ? session->fs : NULL);
+    output_use(session ? &session->output : NULL);
+    journal_use(session ? &session->journal : NULL);
+    return previous;
+}
+
+out_buf_t* shell_session_output(shell_session_t* session) {
+    return &session->output.buffer;
+}
+
+/**
+ * Process and execute a command line, returning its exit status
+ */
+int process_command(shell_session_t* session, char *input, vect_t *args_vector) {
+    if (!input || strlen(input) == 0) {
+        return SHELL_STATUS_OK;
+    }
+    shell_session_t* previous = shell_session_use(session);
+
+    // Initialize virtual filesystem if needed
+    init_fs(session);
+
+    arena_mark_t mark = arena_mark(&session->command_arena);
+    command_list_t list = {0};
+    const command_list_t* cached = NULL;
+    int result = 0;
+
+    // Reuse the parse of a recent identical line; otherwise tokenize input
+    // if args_vector is empty, or borrow its tokens as a single command
+    if (vect_size(args_vector) == 0) {
+        size_t len = strlen(input);
+        unsigned int hash = line_hash(input, len);
+        cached = line_cache_find(session, input, len, hash);
+        if (cached) {
+            session->line_hits++;
+        } else {
+            session->line_misses++;
+            result = parse_line(&session->command_arena, input, &list);
+            if (result == 0) {
+                line_cache_store(session, input, len, hash, &list);
+            }
+        }
     } else {
-        custom_printf("Unknown command: %s\n", command);
-        custom_printf("Type 'help' for a list of commands\n");
+        int argc = vect_size(args_vector);
+        const char** argv = arena_alloc(&session->command_arena, (argc + 1) * sizeof(char*));
+        command_t* command = arena_alloc(&session->command_arena, sizeof(command_t));
+        pipeline_t* pipeline = command_list_add(&session->command_arena, &list);
+        if (argv && command && pipeline) {
+            for (int i = 0; i < argc; i++) {
+                argv[i] = vect_get(args_vector, i);
+            }
+            argv[argc] = NULL;
+            memset(command, 0, sizeof(command_t));
+            command->argc = argc;
+            command->argv = argv;
+            pipeline->count = 1;
+            pipeline->commands = command;
+        } else {
+            result = -1;
+        }
     }
 
-    if (should_delete_vector) {
-        vect_delete(args_vector);
+    int status;
+    if (result < 0) {
+        custom_printf("shell: out of memory\n");
+        status = SHELL_STATUS_ERROR;
+    } else if (result > 0) {
+        custom_printf("shell: syntax error near unexpected token `%s'\n", list.unexpected);
+        status = SHELL_STATUS_SYNTAX;
+    } else {
+        status = run_command_list(session, cached ? cached : &list);
     }
-}
\ No newline at end of file
+
+    arena_rewind(&session->command_arena, mark);
+    shell_session_use(previous);
+    return status;
+}
@@ -0,0 +1,80 @@
+#ifndef _SHELL_H
+#define _SHELL_H
+
+#include <stddef.h>
+
+#include "vect.h"
+#include "vfs.h"
+
+/* Exit statuses returned by process_command. */
+#define SHELL_STATUS_OK 0
+#define SHELL_STATUS_ERROR 1
+#define SHELL_STATUS_SYNTAX 2
+#define SHELL_STATUS_NOT_FOUND 127
+#define SHELL_STATUS_EXIT -1      /* The command asked the shell to exit. */
+
+struct out_buf;
+
+/**
+ * A shell: working directories, filesystem, output buffer, journal, and
+ * the caches and statistics of its commands. Sessions are independent, so
+ * a process can host any number of them and run them on any threads, as
+ * long as each session is driven by one thread at a time.
+ */
+typedef struct shell_session shell_session_t;
+
+/** A new session on the initial filesystem, or NULL if memory is
+ *  exhausted. The initial filesystem is one frozen image that all such
+ *  sessions share, so each pays only for what it changes. */
+shell_session_t *shell_session_new(void);
+
+/** A new session on a frozen image (see vfs_new_overlay), e.g. a template
+ *  from snapshot_load_image, or on an empty filesystem for NULL. The image
+ *  must outlive the session. */
+shell_session_t *shell_session_new_on(const vfs_t *image);
+
+/** Free a session and everything it owns. */
+void shell_session_delete(shell_session_t *session);
+
+/** Make session the calling thread's current one (NULL for none) and
+ *  return the previous one. The current session's filesystem, output and
+ *  journal are the ones vfs.h, output.h, journal.h and snapshot.h act on;
+ *  process_command makes its session current while it runs. */
+shell_session_t *shell_session_use(shell_session_t *session);
+
+/** The buffer the session's commands print into. */
+struct out_buf *shell_session_output(shell_session_t *session);
+
+/** Process and execute a command in a session, returning its exit
+ *  status. The input is tokenized unless args_vector already holds the
+ *  tokens. */
+int process_command(shell_session_t *session, char *input, vect_t *args_vector);
+
+/** Replace the session's filesystem with a snapshot image (see
+ *  snapshot.h) and fix up the working directory. Returns 0, or -1 with
+ *  errno set; on failure the shell starts over from its initial
+ *  filesystem. */
+int shell_restore(shell_session_t *session, const void *image, size_t size);
+
+/** Save an image of the session's filesystem to a file of the host (see
+ *  snapshot_save_file). Returns 0, or -1 with errno set. */
+int shell_save_file(shell_session_t *session, const char *path);
+
+/** Replace the session's filesystem with an image from a file of the
+ *  host, like shell_restore. Commands never reach the host's files; only
+ *  the program driving the session does, through these. */
+int shell_load_file(shell_session_t *session, const char *path);
+
+/** Replay journal records (see journal.h) on top of the session's
+ *  filesystem, e.g. after restoring their base snapshot. Returns 0, or -1
+ *  with errno set at the first record that fails. */
+int shell_replay_journal(shell_session_t *session, const char *data, size_t len);
+
+/** Hits and misses of the session's cache of recently parsed lines. */
+void shell_line_cache_stats(shell_session_t *session, unsigned long *hits, unsigned long *misses);
+
+/** Append the session's per-command counters (see stats.h) and line cache
+ *  numbers as one JSON object. Returns 0, or -1 if memory is exhausted. */
+int shell_stats_json(shell_session_t *session, struct out_buf *b);
+
+#endif /* ifndef _SHELL_H */
@@ -0,0 +1,348 @@
+/**
+ * Saving and loading binary images of the virtual filesystem, see
+ * snapshot.h for the format.
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "journal.h"
+#include "snapshot.h"
+#include "vfs.h"
+
+#define SNAPSHOT_ALIGN 8
+
+static size_t align_up(size_t n) {
+    return (n + SNAPSHOT_ALIGN - 1) & ~(size_t)(SNAPSHOT_ALIGN - 1);
+}
+
+/** The entry after node in pre-order, or NULL. *depth follows the walk. */
+static fs_entry_t *next_preorder(fs_entry_t *node, size_t *depth) {
+    fs_entry_t *child = fs_first_child(node);
+    if (child) {
+        (*depth)++;
+        return child;
+    }
+    for (; node; node = fs_parent(node), (*depth)--) {
+        fs_entry_t *sibling = fs_next_sibling(node);
+        if (sibling) {
+            return sibling;
+        }
+    }
+    return NULL;
+}
+
+size_t snapshot_size(void) {
+    size_t count = 0, strings = 0, blobs = 0, depth = 0;
+
+    for (fs_entry_t *node = fs_root(); node; node = next_preorder(node, &depth)) {
+        count++;
+        strings += node->parent ? strlen(fs_entry_basename(node)) : 0;
+        blobs += node->size;
+    }
+    return sizeof(snapshot_header_t) + count * sizeof(snapshot_record_t) +
+           align_up(strings) + blobs;
+}
+
+size_t snapshot_write(char *buf) {
+    size_t count = 0, strings_size = 0, depth = 0;
+
+    for (fs_entry_t *node = fs_root(); node; node = next_preorder(node, &depth)) {
+        count++;
+        strings_size += node->parent ? strlen(fs_entry_basename(node)) : 0;
+    }
+
+    snapshot_header_t header = {SNAPSHOT_MAGIC, SNAPSHOT_VERSION, (uint32_t)count};
+    header.records_offset = sizeof(snapshot_header_t);
+    header.strings_offset = header.records_offset + count * sizeof(snapshot_record_t);
+    header.strings_size = strings_size;
+    header.blobs_offset = header.strings_offset + align_up(strings_size);
+
+    // Record index of the ancestor at each depth, for the parent fields
+    uint32_t *ancestors = malloc((count + 1) * sizeof(uint32_t));
+    if (!ancestors) {
+        errno = ENOMEM;
+        return 0;
+    }
+
+    char *records = buf + header.records_offset;
+    char *strings = buf + header.strings_offset;
+    char *blobs = buf + header.blobs_offset;
+    size_t name_offset = 0, blob_offset = 0;
+    uint32_t index = 0;
+    depth = 0;
+    for (fs_entry_t *node = fs_root(); node; node = next_preorder(node, &depth), index++) {
+        ancestors[depth] = index;
+
+        const char *name = node->parent ? fs_entry_basename(node) : "";
+        snapshot_record_t record = {
+            .parent = depth > 0 ? ancestors[depth - 1] : 0,
+            .flags = node->is_dir ? SNAPSHOT_DIR : 0,
+            .name_offset = (uint32_t)name_offset,
+            .name_length = (uint32_t)strlen(name),
+            .created = node->created,
+            .modified = node->modified,
+            .content_offset = blob_offset,
+            .content_size = node->size,
+        };
+        memcpy(records + index * sizeof(record), &record, sizeof(record));
+        memcpy(strings + name_offset, name, record.name_length);
+        name_offset += record.name_length;
+        if (node->size > 0) {
+            memcpy(blobs + blob_offset, node->content, node->size);
+            blob_offset += node->size;
+        }
+    }
+    free(ancestors);
+
+    memset(strings + strings_size, 0, align_up(strings_size) - strings_size);
+    header.blobs_size = blob_offset;
+    memcpy(buf, &header, sizeof(header));
+    return header.blobs_offset + blob_offset;
+}
+
+/** Is [offset, offset + len) inside a region of size bytes? */
+static int in_bounds(uint64_t offset, uint64_t len, uint64_t size) {
+    return offset <= size && len <= size - offset;
+}
+
+static snapshot_record_t read_record(const char *records, uint32_t i) {
+    snapshot_record_t record;
+    memcpy(&record, records + (size_t)i * sizeof(record), sizeof(record));
+    return record;
+}
+
+/** Is a name one a path can reach: not "", "." or "..", and free of '/'
+ *  and NUL bytes? */
+static bool valid_name(const char *name, uint32_t len) {
+    if (len == 0 || (name[0] == '.' && (len == 1 || (len == 2 && name[1] == '.')))) {
+        return false;
+    }
+    return !memchr(name, '/', len) && !memchr(name, '\0', len);
+}
+
+static uint32_t name_hash(uint32_t parent, const char *name, uint32_t len) {
+    uint32_t hash = 2166136261u ^ parent;
+    for (uint32_t i = 0; i < len; i++) {
+        hash ^= (unsigned char)name[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/** Do two records of a valid image share a parent and a name? Returns 1,
+ *  0, or -1 if memory is exhausted. */
+static int has_duplicates(const char *records, const char *strings, uint32_t count) {
+    size_t capacity = 16;
+    while (capacity < 2 * (size_t)count) {
+        capacity *= 2;
+    }
+    uint32_t *slots = calloc(capacity, sizeof(uint32_t));   // record index + 1
+    if (!slots) {
+        return -1;
+    }
+    int found = 0;
+    for (uint32_t i = 1; i < count && !found; i++) {
+        snapshot_record_t record = read_record(records, i);
+        const char *name = strings + record.name_offset;
+        size_t slot = name_hash(record.parent, name, record.name_length) & (capacity - 1);
+        for (; slots[slot] != 0; slot = (slot + 1) & (capacity - 1)) {
+            snapshot_record_t other = read_record(records, slots[slot] - 1);
+            if (other.parent == record.parent && other.name_length == record.name_length &&
+                memcmp(strings + other.name_offset, name, record.name_length) == 0) {
+                found = 1;
+                break;
+            }
+        }
+        slots[slot] = i + 1;
+    }
+    free(slots);
+    return found;
+}
+
+/** Check the header and every record before the filesystem is touched.
+ *  Returns 0, or -1 with errno set to EINVAL or ENOMEM. */
+static int snapshot_validate(const char *image, size_t size, snapshot_header_t *header) {
+    errno = EINVAL;
+    if (size < sizeof(*header)) {
+        return -1;
+    }
+    memcpy(header, image, sizeof(*header));
+    if (memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != SNAPSHOT_VERSION || header->entry_count == 0 ||
+        !in_bounds(header->records_offset, (uint64_t)header->entry_count * sizeof(snapshot_record_t), size) ||
+        !in_bounds(header->strings_offset, header->strings_size, size) ||
+        !in_bounds(header->blobs_offset, header->blobs_size, size)) {
+        return -1;
+    }
+
+    const char *records = image + header->records_offset;
+    const char *strings = image + header->strings_offset;
+    for (uint32_t i = 0; i < header->entry_count; i++) {
+        snapshot_record_t record = read_record(records, i);
+        if (!in_bounds(record.name_offset, record.name_length, header->strings_size) ||
+            !in_bounds(record.content_offset, record.content_size, header->blobs_size)) {
+            return -1;
+        }
+        if (i == 0) {
+            // The root: a nameless directory
+            if (record.name_length != 0 || !(record.flags & SNAPSHOT_DIR)) {
+                return -1;
+            }
+            continue;
+        }
+        if (record.parent >= i || !valid_name(strings + record.name_offset, record.name_length) ||
+            !(read_record(records, record.parent).flags & SNAPSHOT_DIR) ||
+            ((record.flags & SNAPSHOT_DIR) && record.content_size != 0)) {
+            return -1;
+        }
+    }
+
+    // A name twice in one directory would only be found part way through
+    // loading, after the old tree is gone
+    int duplicates = has_duplicates(records, strings, header->entry_count);
+    if (duplicates != 0) {
+        errno = duplicates < 0 ? ENOMEM : EINVAL;
+        return -1;
+    }
+    return 0;
+}
+
+int snapshot_load(const void *data, size_t size) {
+    const char *image = data;
+    snapshot_header_t header;
+    if (snapshot_validate(image, size, &header) != 0) {
+        return -1;
+    }
+
+    const char *records = image + header.records_offset;
+    const char *strings = image + header.strings_offset;
+    const char *blobs = image + header.blobs_offset;
+    fs_entry_t **nodes = malloc(header.entry_count * sizeof(fs_entry_t *));
+    int result = 0;
+    if (!nodes) {
+        errno = ENOMEM;
+        return -1;
+    }
+
+    // The image is the new base of the journal
+    journal_suspend();
+    fs_clear();
+    for (uint32_t i = 0; i < header.entry_count; i++) {
+        snapshot_record_t record = read_record(records, i);
+        bool is_dir = record.flags & SNAPSHOT_DIR;
+        fs_entry_t *entry = i == 0 ? add_fs_entry("/", is_dir)
+                                   : fs_add_child(nodes[record.parent], strings + record.name_offset,
+                                                  record.name_length, is_dir);
+        if (!entry ||
+            fs_set_content(entry, blobs + record.content_offset, record.content_size) != 0) {
+            result = -1;
+            break;
+        }
+        entry->created = (time_t)record.created;
+        entry->modified = (time_t)record.modified;
+        nodes[i] = entry;
+    }
+    if (result != 0) {
+        fs_clear();
+    }
+    journal_resume();
+    journal_reset();
+    free(nodes);
+    return result;
+}
+
+vfs_t *snapshot_load_image(const void *image, size_t size) {
+    vfs_t *vfs = vfs_new();
+    if (!vfs) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    journal_t quiet = {0};
+    vfs_t *previous_fs = vfs_use(vfs);
+    journal_t *previous_journal = journal_use(&quiet);
+    int result = snapshot_load(image, size);
+    int saved_errno = errno;
+    journal_use(previous_journal);
+    journal_destroy(&quiet);
+    vfs_use(previous_fs);
+    if (result != 0) {
+        vfs_delete(vfs);
+        errno = saved_errno;
+        return NULL;
+    }
+    vfs_freeze(vfs);
+    return vfs;
+}
+
+int snapshot_save_file(const char *path) {
+    size_t size = snapshot_size();
+    char *buf = malloc(size);
+    if (!buf) {
+        errno = ENOMEM;
+        return -1;
+    }
+    if (snapshot_write(buf) == 0) {
+        free(buf);
+        return -1;
+    }
+
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        free(buf);
+        return -1;
+    }
+    size_t written = 0;
+    while (written < size) {
+        ssize_t n = write(fd, buf + written, size - written);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        written += n;
+    }
+    int saved_errno = errno;
+    free(buf);
+    if (close(fd) != 0 || written < size) {
+        errno = written < size ? saved_errno : errno;
+        return -1;
+    }
+    // The saved image is the new base of the journal
+    journal_reset();
+    return 0;
+}
+
+int snapshot_load_file(const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return -1;
+    }
+    if (st.st_size < (off_t)sizeof(snapshot_header_t)) {
+        close(fd);
+        errno = EINVAL;
+        return -1;
+    }
+
+    void *image = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (image == MAP_FAILED) {
+        return -1;
+    }
+    int result = snapshot_load(image, st.st_size);
+    int saved_errno = errno;
+    munmap(image, st.st_size);
+    errno = saved_errno;
+    return result;
+}
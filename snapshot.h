@@ -0,0 +1,84 @@
+#ifndef _SNAPSHOT_H
+#define _SNAPSHOT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "vfs.h"
+
+/**
+ * Binary image of the whole virtual filesystem.
+ *
+ * Layout: a header, one fixed-size record per entry, a string table of
+ * entry names (the last path component, not NUL-terminated) and the
+ * content blobs. Records are in pre-order, so every parent comes before
+ * its children and siblings keep their order. Integers are stored in host
+ * byte order; every target we build for is little-endian.
+ *
+ * Loading first validates the whole image, then rebuilds the filesystem
+ * from it entry by entry, copying every name and content blob into the
+ * new entries (content big enough to share is hashed into the blob
+ * store, see fs_set_content). It costs time and memory in proportion to
+ * the size of the image, and the image is no longer needed once it
+ * returns.
+ */
+#define SNAPSHOT_MAGIC "MSHSNAP"    /* 8 bytes with the NUL. */
+#define SNAPSHOT_VERSION 1
+
+#define SNAPSHOT_DIR 0x1            /* snapshot_record_t.flags */
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t entry_count;
+    uint64_t records_offset;
+    uint64_t strings_offset;
+    uint64_t strings_size;
+    uint64_t blobs_offset;
+    uint64_t blobs_size;
+} snapshot_header_t;
+
+typedef struct {
+    uint32_t parent;                /* Record index; the root's is 0. */
+    uint32_t flags;
+    uint32_t name_offset;           /* Into the string table. */
+    uint32_t name_length;
+    int64_t created;
+    int64_t modified;
+    uint64_t content_offset;        /* Into the blob area. */
+    uint64_t content_size;
+} snapshot_record_t;
+
+/** Bytes needed for an image of the current filesystem. */
+size_t snapshot_size(void);
+
+/** Write an image of the current filesystem into buf, which must hold
+ *  snapshot_size() bytes. Returns the number of bytes written, or 0 with
+ *  errno set to ENOMEM. */
+size_t snapshot_write(char *buf);
+
+/** Replace the filesystem with the one in an image, which becomes the new
+ *  base of the journal (see journal.h). Returns 0, or -1 with
+ *  errno set to EINVAL for a malformed image or ENOMEM. The filesystem is
+ *  left untouched if the image is malformed (anything out of bounds, or
+ *  a name that is "", ".", "..", holds '/' or NUL, or repeats in its
+ *  directory), and empty if memory ran out part way. */
+int snapshot_load(const void *image, size_t size);
+
+/** A new frozen filesystem holding the one in an image, to share as the
+ *  base of overlays (see vfs_new_overlay), e.g. a template every session
+ *  starts from. Returns NULL with errno set as for snapshot_load. The
+ *  calling thread's filesystem and journal are left alone. */
+vfs_t *snapshot_load_image(const void *image, size_t size);
+
+/** Save an image of the filesystem to a file of the host, which becomes
+ *  the new base of the journal (see journal.h). Returns 0, or -1 with
+ *  errno set. */
+int snapshot_save_file(const char *path);
+
+/** Load an image from a file of the host, mapping it rather than reading
+ *  it into a buffer; the load still copies what it needs, as above.
+ *  Returns 0, or -1 with errno set. */
+int snapshot_load_file(const char *path);
+
+#endif /* ifndef _SNAPSHOT_H */
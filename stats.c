@@ -0,0 +1,114 @@
+/**
+ * Per-command latency and cost counters, see stats.h.
+ */
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdarg.h>
+#include <time.h>
+
+#include "alloc.h"
+#include "output.h"
+#include "stats.h"
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+void stats_begin(stats_sample_t *sample) {
+    sample->ns = now_ns();
+    sample->bytes = output_written();
+    sample->allocs = mem_alloc_count();
+}
+
+void stats_end(stats_sample_t *sample) {
+    sample->ns = now_ns() - sample->ns;
+    sample->bytes = output_written() - sample->bytes;
+    sample->allocs = mem_alloc_count() - sample->allocs;
+}
+
+/** Bucket of a latency: the bit length of its whole microseconds. */
+static int bucket_of(uint64_t ns) {
+    uint64_t us = ns / 1000;
+    int bucket = us ? 64 - __builtin_clzll(us) : 0;
+    return bucket < STATS_BUCKETS ? bucket : STATS_BUCKETS - 1;
+}
+
+void stats_add(stats_counter_t *counter, const stats_sample_t *sample, int status) {
+    counter->calls++;
+    counter->errors += status != 0;
+    counter->total_ns += sample->ns;
+    if (sample->ns > counter->max_ns) {
+        counter->max_ns = sample->ns;
+    }
+    counter->bytes += sample->bytes;
+    counter->allocs += sample->allocs;
+    counter->histogram[bucket_of(sample->ns)]++;
+}
+
+uint64_t stats_quantile_us(const stats_counter_t *counter, double q) {
+    if (counter->calls == 0) {
+        return 0;
+    }
+    // The rank of the quantile, counting from 1
+    unsigned long rank = (unsigned long)(q * counter->calls);
+    if (rank < q * counter->calls || rank == 0) {
+        rank++;
+    }
+    // No bucket bound is better than the slowest run, which also bounds
+    // the open-ended last bucket
+    uint64_t max_us = (counter->max_ns + 999) / 1000;
+    unsigned long seen = 0;
+    for (int i = 0; i < STATS_BUCKETS - 1; i++) {
+        seen += counter->histogram[i];
+        if (seen >= rank) {
+            uint64_t bound = (uint64_t)1 << i;
+            return bound < max_us ? bound : max_us;
+        }
+    }
+    return max_us;
+}
+
+void stats_print_header(void) {
+    custom_printf("%-8s %8s %7s %10s %9s %9s %9s %10s %9s\n", "command", "calls", "errors",
+                  "total ms", "p50 us", "p99 us", "max us", "output", "allocs");
+}
+
+void stats_print_row(const char *name, const stats_counter_t *counter) {
+    custom_printf("%-8s %8lu %7lu %10.3f %9llu %9llu %9llu %10llu %9llu\n", name, counter->calls,
+                  counter->errors, counter->total_ns / 1e6,
+                  (unsigned long long)stats_quantile_us(counter, 0.5),
+                  (unsigned long long)stats_quantile_us(counter, 0.99),
+                  (unsigned long long)((counter->max_ns + 999) / 1000),
+                  (unsigned long long)counter->bytes, (unsigned long long)counter->allocs);
+}
+
+static int json_printf(out_buf_t *b, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    int result = out_buf_vprintf(b, format, args);
+    va_end(args);
+    return result < 0 ? -1 : 0;
+}
+
+int stats_write_json(out_buf_t *b, const char *name, const stats_counter_t *counter) {
+    if (json_printf(b, "{\"name\": \"%s\", \"calls\": %lu, \"errors\": %lu, "
+                    "\"total_us\": %llu, \"max_us\": %llu, \"p50_us\": %llu, \"p99_us\": %llu, "
+                    "\"bytes\": %llu, \"allocs\": %llu, \"histogram_us\": [",
+                    name, counter->calls, counter->errors,
+                    (unsigned long long)(counter->total_ns / 1000),
+                    (unsigned long long)((counter->max_ns + 999) / 1000),
+                    (unsigned long long)stats_quantile_us(counter, 0.5),
+                    (unsigned long long)stats_quantile_us(counter, 0.99),
+                    (unsigned long long)counter->bytes,
+                    (unsigned long long)counter->allocs) != 0) {
+        return -1;
+    }
+    for (int i = 0; i < STATS_BUCKETS; i++) {
+        if (json_printf(b, i ? ", %lu" : "%lu", (unsigned long)counter->histogram[i]) != 0) {
+            return -1;
+        }
+    }
+    return json_printf(b, "]}");
+}
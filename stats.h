@@ -0,0 +1,56 @@
+#ifndef _STATS_H
+#define _STATS_H
+
+#include <stdint.h>
+
+#include "output.h"
+
+/**
+ * Per-command instrumentation: how often each command ran, a latency
+ * histogram, and the output and allocations it cost. Measuring a run
+ * reads the clock and two counters before and after, so it stays on in
+ * every build.
+ *
+ * Latencies go into power-of-two buckets of microseconds: bucket 0 counts
+ * runs under 1 us, bucket i runs in [2^(i-1), 2^i) us, and the last
+ * bucket everything slower.
+ */
+#define STATS_BUCKETS 24
+
+typedef struct {
+    unsigned long calls;
+    unsigned long errors;           /* Runs with a non-zero status. */
+    uint64_t total_ns;
+    uint64_t max_ns;
+    uint64_t bytes;                 /* Bytes of output. */
+    uint64_t allocs;                /* Allocations, see mem_alloc_count. */
+    uint32_t histogram[STATS_BUCKETS];
+} stats_counter_t;
+
+/** One measured run. stats_begin takes the readings, stats_end turns
+ *  them into what the run cost. */
+typedef struct {
+    uint64_t ns;
+    uint64_t bytes;
+    uint64_t allocs;
+} stats_sample_t;
+
+void stats_begin(stats_sample_t *sample);
+void stats_end(stats_sample_t *sample);
+
+/** Add a finished sample to a counter. */
+void stats_add(stats_counter_t *counter, const stats_sample_t *sample, int status);
+
+/** Upper bound in microseconds of the q-th quantile (0 < q <= 1) of the
+ *  latencies, from the histogram; 0 when nothing ran. */
+uint64_t stats_quantile_us(const stats_counter_t *counter, double q);
+
+/** Print a counter as a row of the stats table, after stats_print_header. */
+void stats_print_header(void);
+void stats_print_row(const char *name, const stats_counter_t *counter);
+
+/** Append a counter as a JSON object with the given name. Returns 0, or
+ *  -1 if memory is exhausted. */
+int stats_write_json(out_buf_t *b, const char *name, const stats_counter_t *counter);
+
+#endif /* ifndef _STATS_H */
@@ -4,11 +4,14 @@ from unittest import TestCase
 
 import unittest
 
+import json
 import os.path
 import sys
 import subprocess
 import random
 import re
+import struct
+import tempfile
 
 from shell_test_helpers import *
 
@@ -105,6 +108,250 @@ class ShellTests(ShellTestCase):
         actual = self.run_shell(script)
         self.assertEqual(actual, "one\ntwo\nthree")
 
+    def test10(self):
+        """ -c runs its argument without prompts """
+        rc, actual = execute(SHELL, "-c", "echo one; echo two\necho three")
+        self.assertEqual(rc, 0)
+        self.assertEqual(actual, "one\ntwo\nthree")
+
+    def test11(self):
+        """ -c exits with the status of the last command """
+        rc, actual = execute(SHELL, "-c", "echo one; nosuchcommand")
+        self.assertEqual(rc, 127)
+
+    def test12(self):
+        """ Lines longer than 255 characters work """
+        word = "x" * 5000
+        actual = self.run_shell(f"echo {word} end\n")
+        self.assertEqual(actual, f"{word} end")
+
+    def test13(self):
+        """ Many commands in one script all run """
+        script = "".join(f"echo line{i}\n" for i in range(20000))
+        actual = self.run_shell(script)
+        lines = actual.splitlines()
+        self.assertEqual(len(lines), 20000)
+        self.assertEqual(lines[-1], "line19999")
+
+    def test14(self):
+        """ The initial files can be changed, removed and created again """
+        rc, actual = execute(SHELL, "-c",
+                             "echo more >> README.md; cat README.md | tail -1\n"
+                             "mkdir docs; rm README.md; ls\n"
+                             "echo new > README.md; ls; cat README.md\n"
+                             "cd /; rm -r /home; ls; mkdir /home; ls")
+        self.assertEqual(rc, 0)
+        self.assertEqual(actual, "more\ndocs\ndocs\nREADME.md\nnew\nhome")
+
+    def test15(self):
+        """ cp copies files, and a copy changes independently """
+        rc, actual = execute(SHELL, "-c",
+                             "echo hello > a; cp a b; mkdir d; cp a b d\n"
+                             "echo more >> b; cat a; cat b; cd d; ls; cat a\n"
+                             "cp a a; cp nosuch x")
+        self.assertEqual(rc, 1)
+        self.assertEqual(actual, "hello\nhello\nmore\na\nb\nhello\n"
+                                 "cp: 'a' and 'a' are the same file\n"
+                                 "cp: cannot stat 'nosuch': No such file or directory")
+
+    def test16(self):
+        """ mv renames and moves whole trees, cp -r copies them """
+        rc, actual = execute(SHELL, "-c",
+                             "mkdir d; mkdir d/sub; echo one > d/a; echo two > d/sub/b\n"
+                             "mv d e; ls; cat e/a; cat e/sub/b\n"
+                             "cp -r e f; echo changed > f/sub/b; cat e/sub/b; cat f/sub/b\n"
+                             "mv e/a f; cd f; ls; cd ..\n"
+                             "mv README.md notes; ls\n"
+                             "mv f f/sub; mv nosuch x")
+        self.assertEqual(rc, 1)
+        self.assertEqual(actual, "README.md\ne\none\ntwo\ntwo\nchanged\nsub\na\ne\nf\nnotes\n"
+                                 "mv: cannot move 'f' to a subdirectory of itself, 'f/sub'\n"
+                                 "mv: cannot stat 'nosuch': No such file or directory")
+
+    def test17(self):
+        """ Paths with '.', '..' and '//' resolve, and cd follows a moved directory """
+        rc, actual = execute(SHELL, "-c",
+                             "mkdir d; mkdir d/e; cd d/./e/..//e; pwd; echo hi > ../../f\n"
+                             "cd ../..; cat d/../f; cd d/e; mv /home/d /home/g; pwd\n"
+                             "cd ..; ls; rm .")
+        self.assertEqual(rc, 1)
+        self.assertEqual(actual, "/home/d/e\nhi\n/home/g/e\ne\n"
+                                 "rm: refusing to remove '.' or '..' directory: skipping '.'")
+
+    def test18(self):
+        """ Unquoted *, ? and [...] expand to the matching paths in sorted order """
+        rc, actual = execute(SHELL, "-c",
+                             "touch b.log a.log c.txt; mkdir d; touch d/x.log\n"
+                             "echo *.log \"*.log\"; echo ?.txt [ab].log [!a]*.log\n"
+                             "echo */*.log; echo *.nope; rm *.log; ls")
+        self.assertEqual(rc, 0)
+        self.assertEqual(actual, "a.log b.log *.log\nc.txt a.log b.log b.log\n"
+                                 "d/x.log\n*.nope\nREADME.md\nc.txt\nd")
+
+    def test19(self):
+        """ tail keeps only the last lines, for any count, and rejects one too large """
+        script = "; ".join(f"echo l{i} >> f" for i in range(40))
+        rc, actual = execute(SHELL, "-c",
+                             script + "\n"
+                             "tail -n 2 f; cat f | tail -n 17 | head -n 1\n"
+                             "tail -n 100000000000 f | wc -l; tail -n 0 f\n"
+                             "cat f | tail -n 2305843009213693952")
+        self.assertEqual(rc, 1)
+        self.assertEqual(actual, "l38\nl39\nl23\n40\n"
+                                 "tail: number of lines too large: 2305843009213693952")
+
+    def test20(self):
+        """ --save and --load carry the filesystem over, and commands cannot reach the host """
+        with tempfile.TemporaryDirectory() as tmp:
+            image = os.path.join(tmp, "fs.img")
+            rc, actual = execute(SHELL, "--save", image, "-c",
+                                 "mkdir d; echo hi > d/f; cd d; save " + image)
+            self.assertEqual(rc, 127)
+            self.assertEqual(actual, "Unknown command: save\n"
+                                     "Type 'help' for a list of commands")
+
+            rc, actual = execute(SHELL, "--load", image, "-c", "pwd; cat d/f; ls")
+            self.assertEqual(rc, 0)
+            self.assertEqual(actual, "/home\nhi\nREADME.md\nd")
+
+    def test21(self):
+        """ --load rejects an image with a name no path can reach, or one used twice """
+        with tempfile.TemporaryDirectory() as tmp:
+            image = os.path.join(tmp, "fs.img")
+            rc, _ = execute(SHELL, "--save", image, "-c", "touch q1 q2")
+            self.assertEqual(rc, 0)
+            with open(image, "rb") as f:
+                good = f.read()
+            strings = struct.unpack_from("<Q", good, 24)[0]
+            at = good.index(b"q1", strings)
+
+            for name in [b"..", b"q/", b"q\0", b"q2"]:
+                with open(image, "wb") as f:
+                    f.write(good[:at] + name + good[at + 2:])
+                rc, actual = execute(SHELL, "--load", image, "-c", "ls")
+                self.assertEqual(rc, 1)
+                self.assertEqual(actual, f"shell: {image}: Invalid argument")
+
+    def test22(self):
+        """ cat without operands copies its piped or '<' input """
+        rc, actual = execute(SHELL, "-c",
+                             "echo one | cat; echo two > f; cat < f; cat f | cat | cat\n"
+                             "echo three >> f; cat < f | cat > g; cat g; cat")
+        self.assertEqual(rc, 0)
+        self.assertEqual(actual, "one\ntwo\ntwo\ntwo\nthree")
+
+    def test23(self):
+        """ A repeated line reuses its parse but sees the files as they are now """
+        rc, actual = execute(SHELL, "-c",
+                             "ls\ntouch b\nls\necho \"a  b\" > q\necho \"a  b\" > q\n"
+                             "cat q\nrm b\nls\nstats -j")
+        self.assertEqual(rc, 0)
+        lines = actual.splitlines()
+        self.assertEqual(lines[:-1], ["README.md", "README.md", "b", "a  b", "README.md", "q"])
+        self.assertIn('"line_cache": {"hits": 3, "misses": 6}', lines[-1])
+
+    def test24(self):
+        """ time reports a pipeline's cost, and stats counts each pipeline as a whole """
+        rc, actual = execute(SHELL, "-c",
+                             "cat README.md | wc -l; cat README.md | wc -l; mkdir d\n"
+                             "time echo hi\nstats -j\nstats")
+        self.assertEqual(rc, 0)
+        lines = actual.splitlines()
+        self.assertRegex("\n".join(lines[2:6]),
+                         r"^hi\nreal +[0-9.]+ ms\noutput +3 bytes\nallocs +[0-9]+$")
+
+        stats = json.loads(lines[6])
+        commands = {c["name"]: c for c in stats["commands"]}
+        self.assertEqual(sorted(commands), ["cat | wc", "echo", "mkdir"])
+        self.assertEqual(commands["cat | wc"]["calls"], 2)
+        self.assertEqual(commands["echo"]["bytes"], 3)
+        self.assertGreater(commands["mkdir"]["allocs"], 0)
+
+        self.assertRegex(lines[7], r"^command +calls +errors +total ms .* allocs$")
+        self.assertRegex(lines[-2], r"^cat \| wc +2 +0 ")
+
+    def test25(self):
+        """ Replaying the journal of a session on its base gives the same files """
+        with tempfile.TemporaryDirectory() as tmp:
+            base = os.path.join(tmp, "base.img")
+            journal = os.path.join(tmp, "journal")
+            rc, _ = execute(SHELL, "--save", base, "-c", "mkdir old; echo one > old/a")
+            self.assertEqual(rc, 0)
+
+            script = "mkdir d; echo two > d/b; echo more >> old/a; touch d/c\n" \
+                     "mv old d/old; cp -r d e; rm -r d/old; rm README.md\n"
+            check = "ls; cd e; ls; cat b; cd old; ls; cat a"
+            rc, expected = execute(SHELL, "--load", base, "--journal", journal,
+                                   "-c", script + check)
+            self.assertEqual(rc, 0)
+            self.assertEqual(expected, "d\ne\nb\nc\nold\ntwo\na\none\nmore")
+
+            rc, actual = execute(SHELL, "--load", base, "--replay", journal, "-c", check)
+            self.assertEqual(rc, 0)
+            self.assertEqual(actual, expected)
+
+    def test26(self):
+        """ grep, wc, head, sort and uniq filter piped input and files """
+        rc, actual = execute(SHELL, "-c",
+                             "echo b > f; echo a >> f; echo b >> f; echo b >> f; echo C >> f\n"
+                             "head -n 0 f; cat f | head -n 0; head -n 2 f; cat f | head -1\n"
+                             "grep -c b f; cat f | grep -vn b; grep -i c f\n"
+                             "sort f | uniq -c; sort -r f | head -n 1; cat f | wc -l; wc f\n"
+                             "head -n x f")
+        self.assertEqual(rc, 1)
+        self.assertEqual(actual, "b\na\nb\n3\n2:a\n5:C\nC\n"
+                                 "      1 C\n      1 a\n      3 b\nb\n5\n5 5 10\n"
+                                 "head: invalid number of lines: 'x'")
+
+    def test27(self):
+        """ '>' truncates, '>>' appends and '<' reads a file, in and out of pipelines """
+        rc, actual = execute(SHELL, "-c",
+                             "echo one > f; echo two >> f; cat f; echo three > f; cat f\n"
+                             "ls > g; wc -l < g; sort -r < g > h; cat h; cat < h | head -n 1\n"
+                             "echo x > d/nope; mkdir d; echo x > d; cat < nosuch")
+        self.assertEqual(rc, 1)
+        self.assertEqual(actual, "one\ntwo\nthree\n3\ng\nf\nREADME.md\ng\n"
+                                 "shell: d/nope: No such file or directory\n"
+                                 "shell: d: Is a directory\n"
+                                 "shell: nosuch: No such file")
+
+    def test28(self):
+        """ ';' runs commands in turn, and source runs a file's commands in the session """
+        rc, actual = execute(SHELL, "-c",
+                             "echo \"echo one; echo two\" > s; echo \"# comment\" >> s\n"
+                             "echo \"mkdir d; cd d\" >> s; echo pwd >> s\n"
+                             "source s; pwd; cd ..; nosuch; echo after\n"
+                             "echo \"source loop\" > loop; source loop | tail -n 1; source nosuch")
+        self.assertEqual(rc, 1)
+        self.assertEqual(actual, "one\ntwo\n/home/d\n/home/d\n"
+                                 "Unknown command: nosuch\nType 'help' for a list of commands\nafter\n"
+                                 "source: loop: maximum nesting depth exceeded\n"
+                                 "source: nosuch: No such file")
+
+    def test29(self):
+        """ mv replaces a file of the base image or the session, and replays the same """
+        with tempfile.TemporaryDirectory() as tmp:
+            journal = os.path.join(tmp, "journal")
+            script = "echo one > a; mv a README.md; echo two > b; mv b README.md\n" \
+                     "mkdir d; touch d/f; mkdir e; mv e d; mkdir e\n"
+            check = "ls; cat README.md; cd d; ls"
+            rc, expected = execute(SHELL, "--journal", journal, "-c", script + check)
+            self.assertEqual(rc, 0)
+            self.assertEqual(expected, "README.md\nd\ne\ntwo\nf\ne")
+
+            rc, actual = execute(SHELL, "--replay", journal, "-c", check)
+            self.assertEqual(rc, 0)
+            self.assertEqual(actual, expected)
+
+    def test30(self):
+        """ '>' keeps writing to its file when the command moves it, and stops when it is removed """
+        rc, actual = execute(SHELL, "-c",
+                             "mkdir a; mkdir a/b; echo \"echo one; mv /home/a/b/out /home/moved\" > s\n"
+                             "echo \"echo two\" >> s; source s > a/b/out; cat moved\n"
+                             "echo \"rm /home/gone; echo lost\" > t; source t > gone; ls")
+        self.assertEqual(rc, 0)
+        self.assertEqual(actual, "one\ntwo\nREADME.md\na\ns\nmoved\nt")
+
 if __name__ == '__main__':
     print(f"-= {YELLOW}Running tests for {SHELL}{RESET} =-")
     unittest.main(testRunner = unittest.TextTestRunner(resultclass = PrettierTextTestResult))
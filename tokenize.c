@@ -1,4 +1,5 @@
 #include <stdio.h>
+#include <string.h>
 
 #include "tokenize.h"
 
@@ -9,37 +10,192 @@ int is_special_character(char ch) {
   return ch == '(' || ch == ')' || ch == '<' || ch == '>' || ch == ';' || ch == '|'; 
 }
 
+/*
+ * Vectorized scanning. word_length and quoted_string_length look for the
+ * first byte that ends the token 32 (AVX2) or 16 (SSE2, wasm simd128)
+ * bytes at a time. Blocks are loaded from aligned addresses, so a load
+ * never crosses into the next page and reading a few bytes past the
+ * terminating NUL is safe. Define TOKENIZE_NO_SIMD to force the scalar
+ * loops, which are also used when no vector unit is available.
+ */
+#if !defined(TOKENIZE_NO_SIMD) && defined(__AVX2__)
+#include <immintrin.h>
+#define SIMD_WIDTH 32
+typedef __m256i simd_t;
+#define simd_load(p) _mm256_load_si256((const __m256i *)(p))
+#define simd_eq(v, ch) _mm256_cmpeq_epi8((v), _mm256_set1_epi8(ch))
+#define simd_or(a, b) _mm256_or_si256((a), (b))
+#define simd_mask(v) ((uint32_t)_mm256_movemask_epi8(v))
+#elif !defined(TOKENIZE_NO_SIMD) && defined(__SSE2__)
+#include <emmintrin.h>
+#define SIMD_WIDTH 16
+typedef __m128i simd_t;
+#define simd_load(p) _mm_load_si128((const __m128i *)(p))
+#define simd_eq(v, ch) _mm_cmpeq_epi8((v), _mm_set1_epi8(ch))
+#define simd_or(a, b) _mm_or_si128((a), (b))
+#define simd_mask(v) ((uint32_t)_mm_movemask_epi8(v))
+#elif !defined(TOKENIZE_NO_SIMD) && defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+#define SIMD_WIDTH 16
+typedef v128_t simd_t;
+#define simd_load(p) wasm_v128_load(p)
+#define simd_eq(v, ch) wasm_i8x16_eq((v), wasm_i8x16_splat(ch))
+#define simd_or(a, b) wasm_v128_or((a), (b))
+#define simd_mask(v) ((uint32_t)wasm_i8x16_bitmask(v))
+#endif
+
+#ifdef SIMD_WIDTH
+#include <stdint.h>
+
+// The aligned over-read is intentional, keep AddressSanitizer out of it
+#if defined(__GNUC__) || defined(__clang__)
+#define NO_SANITIZE_ADDRESS __attribute__((no_sanitize_address))
+#else
+#define NO_SANITIZE_ADDRESS
+#endif
+
+/** Bit i is set if block[i] ends a word: NUL, space, quote or special. */
+static inline uint32_t word_stop_mask(const char *block) {
+    simd_t v = simd_load(block);
+    simd_t stop = simd_or(simd_or(simd_eq(v, '\0'), simd_eq(v, ' ')), simd_eq(v, '"'));
+    simd_t special = simd_or(simd_or(simd_eq(v, '('), simd_eq(v, ')')),
+                             simd_or(simd_eq(v, '<'), simd_eq(v, '>')));
+    special = simd_or(special, simd_or(simd_eq(v, ';'), simd_eq(v, '|')));
+    return simd_mask(simd_or(stop, special));
+}
+
+/** Bit i is set if block[i] ends a quoted string: NUL or quote. */
+static inline uint32_t quote_stop_mask(const char *block) {
+    simd_t v = simd_load(block);
+    return simd_mask(simd_or(simd_eq(v, '\0'), simd_eq(v, '"')));
+}
+
+/** Offset of the first byte of input flagged by stop_mask. */
+#define SIMD_SCAN(input, stop_mask)                                        \
+    do {                                                                   \
+        uintptr_t misalign = (uintptr_t)(input) & (SIMD_WIDTH - 1);        \
+        const char *block = (input) - misalign;                            \
+        uint32_t mask = stop_mask(block) >> misalign;                      \
+        if (mask) {                                                        \
+            return __builtin_ctz(mask);                                    \
+        }                                                                  \
+        for (;;) {                                                         \
+            block += SIMD_WIDTH;                                           \
+            mask = stop_mask(block);                                       \
+            if (mask) {                                                    \
+                return (int)(block - (input)) + __builtin_ctz(mask);       \
+            }                                                              \
+        }                                                                  \
+    } while (0)
+
 /**
- * Read a quoted string handles everything as a single token
+ * Length of the contents of a quoted string, up to (not including) the
+ * closing quote or the end of the input. input points past the opening quote.
  */
-int read_quoted_string(const char *input, char *output) {
+NO_SANITIZE_ADDRESS
+int quoted_string_length(const char *input) {
+    SIMD_SCAN(input, quote_stop_mask);
+}
+
+/**
+ * Length of the word at the start of input
+ */
+NO_SANITIZE_ADDRESS
+int word_length(const char *input) {
+    SIMD_SCAN(input, word_stop_mask);
+}
+
+#else
+
+/**
+ * Length of the contents of a quoted string, up to (not including) the
+ * closing quote or the end of the input. input points past the opening quote.
+ */
+int quoted_string_length(const char *input) {
     int i = 0;
-    ++input; 
     while (input[i] != '\0' && input[i] != '"') {
-        // copy character to output buffer
-        output[i] = input[i]; 
         ++i;
     }
-    output[i] = '\0'; 
-
-    return i + 2;
+    return i;
 }
 
-
 /**
- * Read a word from the input string
+ * Length of the word at the start of input
  */
-int read_word(const char *input, char *output) {
+int word_length(const char *input) {
     int i = 0;
     // While the character is not a space and not a special shell character, 
     while (input[i] != '\0' && input[i] != ' ' && !is_special_character(input[i]) && input[i] != '"') {
-        // copy character to output buffer
-        output[i] = input[i]; 
         ++i;
     }
-    output[i] = '\0'; 
+    return i;
+}
+
+#endif /* SIMD_WIDTH */
 
-    return i; 
+/**
+ * Read a quoted string handles everything as a single token
+ */
+int read_quoted_string(const char *input, char *output) {
+    int len = quoted_string_length(input + 1);
+    // copy characters to output buffer
+    memcpy(output, input + 1, len);
+    output[len] = '\0'; 
+
+    // skip both quotes, unless the string is unterminated
+    return len + (input[len + 1] == '"' ? 2 : 1);
+}
+
+
+/**
+ * Read a word from the input string
+ */
+int read_word(const char *input, char *output) {
+    int len = word_length(input);
+    // copy characters to output buffer
+    memcpy(output, input, len);
+    output[len] = '\0'; 
+
+    return len; 
+}
+
+/**
+ * Split input into token spans without copying anything. Stores at most
+ * max_spans spans and returns the total number of tokens in the input.
+ */
+int tokenize_spans(const char *input, token_span_t *spans, int max_spans) {
+    int count = 0;
+    int i = 0;
+
+    while (input[i] != '\0') {
+        token_span_t span;
+        if (input[i] == ' ') {
+            ++i;
+            continue;
+        }
+        if (input[i] == '"') {
+            span.kind = TOKEN_STRING;
+            span.offset = i + 1;
+            span.length = quoted_string_length(&input[i + 1]);
+            // skip both quotes, unless the string is unterminated
+            i += span.length + (input[i + 1 + span.length] == '"' ? 2 : 1);
+        } else if (is_special_character(input[i])) {
+            span.kind = TOKEN_SPECIAL;
+            span.offset = i;
+            span.length = 1;
+            ++i;
+        } else {
+            span.kind = TOKEN_WORD;
+            span.offset = i;
+            span.length = word_length(&input[i]);
+            i += span.length;
+        }
+        if (count < max_spans) {
+            spans[count] = span;
+        }
+        ++count;
+    }
+    return count;
 }
 
 #ifdef TOKENIZE_TEST
@@ -1,8 +1,27 @@
 #pragma once
 
+/** Kinds of tokens produced by tokenize_spans. */
+typedef enum {
+    TOKEN_WORD,         /* A run of ordinary characters. */
+    TOKEN_STRING,       /* The contents of a double-quoted string. */
+    TOKEN_SPECIAL,      /* A single special character, see is_special_character. */
+} token_kind_t;
+
+/** A token as a (offset, length) span into the tokenized input. */
+typedef struct {
+    unsigned int offset;
+    unsigned int length;
+    token_kind_t kind;
+} token_span_t;
+
 int is_special_character(char ch);
 
+int quoted_string_length(const char *input);
+
+int word_length(const char *input);
+
 int read_quoted_string(const char *input, char *output);
 
 int read_word(const char *input, char *output);
 
+int tokenize_spans(const char *input, token_span_t *spans, int max_spans);
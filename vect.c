@@ -20,39 +20,121 @@ struct vect {
   char **data;             /* Array containing the actual data. */
   unsigned int size;       /* Number of items currently in the vector. */
   unsigned int capacity;   /* Maximum number of items the vector can hold before growing. */
+
+  /* Small-buffer storage: the first VECT_INITIAL_CAPACITY items and short
+   * strings live inside the vector itself, so short argv lists need no
+   * heap allocation beyond the vector. */
+  char *inline_data[VECT_INITIAL_CAPACITY];
+  char inline_chars[VECT_INLINE_BYTES];
+  unsigned int inline_used;  /* Bytes of inline_chars in use. */
 };
 
+/** Is the string stored in the vector's inline character buffer? */
+static int is_inline(vect_t *v, const char *elt) {
+  return elt >= v->inline_chars && elt < v->inline_chars + VECT_INLINE_BYTES;
+}
+
+/** Free one element unless it lives in the inline buffer. */
+static void free_elt(vect_t *v, char *elt) {
+  if (!is_inline(v, elt)) {
+    free(elt);
+  }
+}
+
+/** Copy n bytes of elt into the inline buffer if they fit, else onto the
+ *  heap. Returns NULL if memory is exhausted. */
+static char *copy_elt(vect_t *v, const char *elt, size_t n) {
+  char *copy;
+
+  if (n < VECT_INLINE_BYTES - v->inline_used) {
+    copy = v->inline_chars + v->inline_used;
+    v->inline_used += n + 1;
+  } else {
+    copy = malloc(n + 1);
+    if (copy == NULL) {
+      return NULL;
+    }
+  }
+  memcpy(copy, elt, n);
+  copy[n] = '\0';
+  return copy;
+}
+
 /** Construct a new empty vector. */
 vect_t *vect_new() {
-
-  /* [TODO] Complete the function */
-  
   // allocate memory for the new vector
   vect_t *v = malloc(sizeof(vect_t));
+  if (v == NULL) {
+    return NULL;
+  }
 
-  // assign values for the vector's fields
+  // start out on the inline storage
   v->size = 0;
-  v->capacity = 2;
-  // allocate memeory for the data
-  v->data = malloc(v->capacity * sizeof(char *));
+  v->capacity = VECT_INITIAL_CAPACITY;
+  v->data = v->inline_data;
+  v->inline_used = 0;
 
   return v;
 }
 
 /** Delete the vector, freeing all memory it occupies. */
 void vect_delete(vect_t *v) {
-
-  /* [TODO] Complete the function */
-
   // free the memory allocated to each item in the data array
-  for (int i = 0; i < v->size; i++) {
-    free(v->data[i]);
-  }
+  vect_clear(v);
   // free the memory allocated to the vectors data
-  free(v->data);
+  if (v->data != v->inline_data) {
+    free(v->data);
+  }
   // free the memory allocated to the vector itself
   free(v);
+}
+
+/** Remove every element, keeping the vector's capacity for reuse. */
+void vect_clear(vect_t *v) {
+  assert(v != NULL);
 
+  for (unsigned int i = 0; i < v->size; i++) {
+    free_elt(v, v->data[i]);
+  }
+  v->size = 0;
+  v->inline_used = 0;
+}
+
+/** Make sure the vector can hold at least capacity items without growing.
+ *  Returns 0, or -1 if memory is exhausted. */
+int vect_reserve(vect_t *v, unsigned int capacity) {
+  assert(v != NULL);
+
+  if (capacity <= v->capacity) {
+    return 0;
+  }
+
+  // grow geometrically so repeated adds stay amortized O(1)
+  unsigned int new_capacity = v->capacity;
+  while (new_capacity < capacity) {
+    if (new_capacity > VECT_MAX_CAPACITY / VECT_GROWTH_FACTOR) {
+      new_capacity = capacity;
+      break;
+    }
+    new_capacity *= VECT_GROWTH_FACTOR;
+  }
+
+  char **new_data;
+  if (v->data == v->inline_data) {
+    new_data = malloc(new_capacity * sizeof(char *));
+    if (new_data != NULL) {
+      memcpy(new_data, v->inline_data, v->size * sizeof(char *));
+    }
+  } else {
+    new_data = realloc(v->data, new_capacity * sizeof(char *));
+  }
+  if (new_data == NULL) {
+    return -1;
+  }
+
+  v->data = new_data;
+  v->capacity = new_capacity;
+  return 0;
 }
 
 /** Get the element at the given index. */
@@ -88,55 +170,67 @@ void vect_set(vect_t *v, unsigned int idx, const char *elt) {
   assert(v != NULL);
   assert(idx < v->size);
 
-  /* [TODO] Complete the function */
-
-  // free the memory for the old element
-  free(v->data[idx]);
-
-  //allocate memeory for the new element
-  v->data[idx] = malloc(strlen(elt) + 1);
-
-  // set the data at idx to the pointer to a new char
-  strcpy(v->data[idx], elt);
-
+  // copy the new element before freeing the old one, elt may point into it
+  char *copy = copy_elt(v, elt, strlen(elt));
+  if (copy == NULL) {
+    return;
+  }
+  free_elt(v, v->data[idx]);
+  v->data[idx] = copy;
 }
 
 /** Add an element to the back of the vector. */
-void vect_add(vect_t *v, const char *elt) {
+int vect_add(vect_t *v, const char *elt) {
   assert(v != NULL);
 
-  /* [TODO] Complete the function */
+  return vect_add_n(v, elt, strlen(elt));
+}
 
-  // check if the vector needs more memeory
-  if (v->size >= v->capacity) {
-    // calculate the new capacity
-    int new_capacity = v->capacity * 2;
-    // reallocate memory to the new data
-    char **new_data = realloc(v->data, new_capacity * sizeof(char *));
-    // update data pointer and the vector's capacity
-    v->data = new_data;
-    v->capacity = new_capacity;
-  }
+/** Add a copy of the first n bytes of elt to the back of the vector. */
+int vect_add_n(vect_t *v, const char *elt, size_t n) {
+  assert(v != NULL);
 
-  // allocate memory for the new char
-  v->data[v->size] = malloc(strlen(elt) + 1);
+  // check if the vector needs more memory
+  if (v->size >= v->capacity && vect_reserve(v, v->size + 1) != 0) {
+    return -1;
+  }
 
-  // copy the char into the allocated memory
-  strcpy(v->data[v->size], elt);
+  // copy the string into the inline buffer or the heap
+  char *copy = copy_elt(v, elt, n);
+  if (copy == NULL) {
+    return -1;
+  }
+  v->data[v->size++] = copy;
+  return 0;
+}
 
-  // increment the size of the vector
-  v->size++;
+/** Add a malloc'd string to the back of the vector without copying it. */
+int vect_add_owned(vect_t *v, char *elt) {
+  assert(v != NULL);
 
+  if (v->size >= v->capacity && vect_reserve(v, v->size + 1) != 0) {
+    return -1;
+  }
+  v->data[v->size++] = elt;
+  return 0;
 }
 
 /** Remove the last element from the vector. */
 void vect_remove_last(vect_t *v) {
   assert(v != NULL);
-
-  /* [TODO] Complete the function */
-
-  // free the memory allocated to the last element in the vector
-  free(v->data[v->size - 1]);
+  assert(v->size > 0);
+
+  char *last = v->data[v->size - 1];
+
+  // give the inline bytes back if this was the newest inline string
+  if (is_inline(v, last)) {
+    size_t len = strlen(last) + 1;
+    if (last + len == v->inline_chars + v->inline_used) {
+      v->inline_used -= len;
+    }
+  } else {
+    free(last);
+  }
 
   // decrement the size
   v->size--;
@@ -2,6 +2,7 @@
 #define _VECT_H
 
 #include <limits.h>
+#include <stddef.h>
 
 /** Type of a vector (fields are hidden). */
 typedef struct vect vect_t;
@@ -22,8 +23,25 @@ char *vect_get_copy(vect_t *v, unsigned int idx);
 /** Set the element at the given index. */
 void vect_set(vect_t *v, unsigned int idx, const char *elt);
 
-/** Add an element to the back of the vector. */
-void vect_add(vect_t *v, const char *elt);
+/** Add an element to the back of the vector. Returns 0, or -1 if memory
+ *  is exhausted. */
+int vect_add(vect_t *v, const char *elt);
+
+/** Add a copy of the first n bytes of elt (which need not be NUL-terminated)
+ *  to the back of the vector. Returns 0 or -1. */
+int vect_add_n(vect_t *v, const char *elt, size_t n);
+
+/** Add a malloc'd string to the back of the vector, which takes ownership
+ *  of it instead of copying. Returns 0, or -1 (elt is then not owned). */
+int vect_add_owned(vect_t *v, char *elt);
+
+/** Remove every element but keep the capacity, so the vector can be reused
+ *  without further allocation. */
+void vect_clear(vect_t *v);
+
+/** Make room for at least capacity items. Returns 0, or -1 if memory is
+ *  exhausted. */
+int vect_reserve(vect_t *v, unsigned int capacity);
 
 /** Remove the last element from the vector. */
 void vect_remove_last(vect_t *v);
@@ -36,8 +54,9 @@ unsigned int vect_current_capacity(vect_t *v);
 
 
 /* Vector configuration. */
-#define VECT_INITIAL_CAPACITY 2
+#define VECT_INITIAL_CAPACITY 8
 #define VECT_GROWTH_FACTOR 2
+#define VECT_INLINE_BYTES 128   /* Bytes of short strings stored inline. */
 
 #define VECT_MAX_CAPACITY UINT_MAX
 
@@ -0,0 +1,1376 @@
+/**
+ * Virtual filesystem: a tree of fs_entry_t nodes plus a name index.
+ *
+ * Nodes are allocated from a slab and never move, so the tree links and
+ * the index can hold plain pointers. A node stores only its own name, and
+ * the index is keyed on the inode number of the parent together with that
+ * name, so a path is resolved one component at a time and moving a
+ * directory rekeys its node alone, however much lies below it.
+ *
+ * Content is either a private buffer from the pool, which appends grow in
+ * place, or a blob of the shared store (blob.h) with capacity 0. Content
+ * set whole (fs_set_content, from VFS_SHARE_MIN bytes), copied
+ * (fs_share_content, fs_copy_tree) or frozen into a base image goes to the
+ * store, so every copy of the same bytes is kept once; the first append
+ * turns it back into a private buffer.
+ *
+ * An overlay (vfs_new_overlay) holds only what differs from its frozen
+ * base image, in nodes of its own:
+ *
+ *  - copies of base entries that were changed or moved, or that are the
+ *    parent of a change, made on the first write ("copy-up"). A copy
+ *    points to its base entry through lower, shares its content until
+ *    that is written, and keeps its inode number, so the base children of
+ *    a copied directory are still found below the copy wherever it moves.
+ *    Copies are also indexed by inode number.
+ *  - entries created in the overlay, or moved there, linked under copies.
+ *  - whiteouts: index-only nodes hiding the name of a base entry that was
+ *    removed or moved away. Removing a base directory takes one whiteout:
+ *    nothing visible has its inode number any more, so the entries below
+ *    it are out of reach.
+ *
+ * A base entry that is not copied therefore has no change anywhere in its
+ * subtree. The children of a copied directory are those of its base entry,
+ * each replaced by its copy or skipped if whited out or moved away,
+ * followed by the entries created or moved into the overlay.
+ */
+#include <assert.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alloc.h"
+#include "blob.h"
+#include "journal.h"
+#include "vfs.h"
+
+#define VFS_SLAB_CHUNK 64
+
+// Slots a filesystem can watch for its users, see vfs_watch
+#define VFS_MAX_WATCHES 16
+
+// Content set whole from this size on is shared through the blob store;
+// below it a private buffer costs less than the blob header
+#define VFS_SHARE_MIN 64
+
+/**
+ * An open-addressing hash table of nodes. The capacity is always a power
+ * of two and is kept at least twice the number of nodes, so probe
+ * sequences stay short.
+ */
+typedef struct fs_table {
+    fs_entry_t **slots;
+    unsigned int capacity;
+    unsigned int count;
+    bool by_ino;                  /* Keyed on ino instead of hash. */
+} fs_table_t;
+
+/**
+ * A filesystem: its nodes with the pool for their names and content, the
+ * name index holding every node, the inode index of the overlay copies,
+ * and the slots its users hold entries in (see vfs_watch).
+ */
+struct vfs {
+    slab_t entries;
+    mem_pool_t pool;              /* Names and content of the entries. */
+    unsigned int visible;         /* Number of entries, base included. */
+    fs_entry_t *root;             /* NULL while the base root is not copied. */
+    unsigned long next_ino;
+    fs_table_t index;             /* Nodes by parent and name. */
+    fs_table_t copies;            /* Copies of base entries by ino. */
+    const vfs_t *base;            /* Image shown below, NULL after fs_clear. */
+    const vfs_t *origin;          /* Image the overlay was made on. */
+    bool frozen;
+    fs_entry_t **watches[VFS_MAX_WATCHES];
+};
+
+// The filesystem the calling thread works on, see vfs_use
+static _Thread_local vfs_t *bound_fs = NULL;
+
+/** The calling thread's filesystem. There is no shared one to fall back
+ *  on, so working without one selected is a bug in the caller. */
+static vfs_t *current_fs(void) {
+    assert(bound_fs && "no filesystem selected, see vfs_use");
+    return bound_fs;
+}
+
+/** FNV-1a hash of the first len bytes of a name, seeded with the inode
+ *  number of its directory. */
+static unsigned int fs_name_hash(unsigned long parent, const char *name, size_t len) {
+    unsigned int hash = 2166136261u ^ (unsigned int)(parent * 2654435761u);
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (unsigned char)name[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static unsigned int fs_ino_hash(unsigned long ino) {
+    return (unsigned int)(ino * 2654435761u);
+}
+
+/** The inode number of the directory holding a node, 0 for the root. */
+static unsigned long fs_parent_ino(const fs_entry_t *entry) {
+    return entry->parent ? entry->parent->ino : 0;
+}
+
+/** The slot a node would take in a table if it were free. */
+static unsigned int fs_table_home(const fs_table_t *table, const fs_entry_t *entry) {
+    unsigned int hash = table->by_ino ? fs_ino_hash(entry->ino) : entry->hash;
+    return hash & (table->capacity - 1);
+}
+
+/** Insert a node into a table (the node must not be in it yet). */
+static void fs_table_insert(fs_table_t *table, fs_entry_t *entry) {
+    unsigned int mask = table->capacity - 1;
+    unsigned int slot = fs_table_home(table, entry);
+    while (table->slots[slot] != NULL) {
+        slot = (slot + 1) & mask;
+    }
+    table->slots[slot] = entry;
+    table->count++;
+}
+
+/** Make room in a table for extra more nodes. */
+static bool fs_table_reserve(fs_table_t *table, unsigned int extra) {
+    unsigned int needed = 2 * (table->count + extra) + 2;
+    if (needed <= table->capacity) {
+        return true;
+    }
+    unsigned int capacity = table->capacity ? table->capacity * 2 : 64;
+    while (capacity < needed) {
+        capacity *= 2;
+    }
+    fs_entry_t **slots = calloc(capacity, sizeof(fs_entry_t *));
+    if (!slots) {
+        return false;
+    }
+    fs_entry_t **old_slots = table->slots;
+    unsigned int old_capacity = table->capacity;
+    table->slots = slots;
+    table->capacity = capacity;
+    table->count = 0;
+    for (unsigned int i = 0; i < old_capacity; i++) {
+        if (old_slots[i]) {
+            fs_table_insert(table, old_slots[i]);
+        }
+    }
+    free(old_slots);
+    return true;
+}
+
+/** Remove a node from a table, shifting later members of its probe run
+ *  back so lookups never need tombstones. */
+static void fs_table_remove(fs_table_t *table, const fs_entry_t *entry) {
+    unsigned int mask = table->capacity - 1;
+    unsigned int hole = fs_table_home(table, entry);
+    while (table->slots[hole] != entry) {
+        hole = (hole + 1) & mask;
+    }
+    table->slots[hole] = NULL;
+    table->count--;
+    for (unsigned int i = (hole + 1) & mask; table->slots[i]; i = (i + 1) & mask) {
+        unsigned int home = fs_table_home(table, table->slots[i]);
+        // Move the node into the hole unless its home lies cyclically in (hole, i]
+        if (((i - home) & mask) >= ((i - hole) & mask)) {
+            table->slots[hole] = table->slots[i];
+            table->slots[i] = NULL;
+            hole = i;
+        }
+    }
+}
+
+/** The node of vfs named by the first len bytes of name in the directory
+ *  with inode number parent, whiteouts included, or NULL. */
+static fs_entry_t *fs_index_get(const vfs_t *vfs, unsigned long parent, const char *name,
+                                size_t len, unsigned int hash) {
+    const fs_table_t *index = &vfs->index;
+    if (index->capacity == 0) {
+        return NULL;
+    }
+    unsigned int mask = index->capacity - 1;
+    for (unsigned int slot = hash & mask; index->slots[slot]; slot = (slot + 1) & mask) {
+        fs_entry_t *entry = index->slots[slot];
+        if (entry->hash == hash && fs_parent_ino(entry) == parent &&
+            strncmp(entry->name, name, len) == 0 && entry->name[len] == '\0') {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+/** The entry named by the first len bytes of name in a directory as seen
+ *  through the overlay, or NULL. */
+static fs_entry_t *fs_lookup(const fs_entry_t *dir, const char *name, size_t len) {
+    vfs_t *fs = current_fs();
+    unsigned int hash = fs_name_hash(dir->ino, name, len);
+    fs_entry_t *entry = fs_index_get(fs, dir->ino, name, len, hash);
+    if (entry) {
+        return entry->whiteout ? NULL : entry;
+    }
+    return fs->base ? fs_index_get(fs->base, dir->ino, name, len, hash) : NULL;
+}
+
+/** The overlay node under the name of a base entry: its copy, a whiteout,
+ *  or an entry created or moved there since. NULL if there is none. */
+static fs_entry_t *fs_cover_of(const fs_entry_t *lower) {
+    vfs_t *fs = current_fs();
+    return fs_index_get(fs, fs_parent_ino(lower), lower->name, strlen(lower->name), lower->hash);
+}
+
+/** The overlay copy of the base entry with the given inode number, or
+ *  NULL. */
+static fs_entry_t *fs_copy_of(unsigned long ino) {
+    vfs_t *fs = current_fs();
+    const fs_table_t *copies = &fs->copies;
+    if (copies->capacity == 0) {
+        return NULL;
+    }
+    unsigned int mask = copies->capacity - 1;
+    for (unsigned int slot = fs_ino_hash(ino) & mask; copies->slots[slot]; slot = (slot + 1) & mask) {
+        if (copies->slots[slot]->ino == ino) {
+            return copies->slots[slot];
+        }
+    }
+    return NULL;
+}
+
+/** What an entry looks like now: a base entry may have been copied,
+ *  moved or removed since the caller found it. NULL if it is gone. */
+static fs_entry_t *fs_visible(fs_entry_t *entry) {
+    vfs_t *fs = current_fs();
+    if (!entry->shared || !fs->base) {
+        return entry;
+    }
+    fs_entry_t *copy = fs_copy_of(entry->ino);
+    if (copy) {
+        return copy;
+    }
+    return fs_cover_of(entry) ? NULL : entry;
+}
+
+/** Is a node a copy that was never moved? Those are listed in the order
+ *  of their base entries, the others in the order they were created or
+ *  moved in, like any entry of the overlay. */
+static bool fs_in_place(const fs_entry_t *entry) {
+    return entry->lower && !entry->moved;
+}
+
+/** The slab of the nodes, set up on first use. */
+static slab_t *fs_slab(void) {
+    vfs_t *fs = current_fs();
+    if (fs->entries.obj_size == 0) {
+        slab_init(&fs->entries, sizeof(fs_entry_t), VFS_SLAB_CHUNK);
+    }
+    return &fs->entries;
+}
+
+/** Allocate a node with a copy of the first len bytes of name. */
+static fs_entry_t *fs_entry_alloc(const char *name, size_t len) {
+    vfs_t *fs = current_fs();
+    fs_entry_t *entry = slab_alloc(fs_slab());
+    if (!entry) {
+        return NULL;
+    }
+    memset(entry, 0, sizeof(*entry));
+
+    entry->name = mem_pool_alloc(&fs->pool, len + 1);
+    if (!entry->name) {
+        slab_free(&fs->entries, entry);
+        return NULL;
+    }
+    memcpy(entry->name, name, len);
+    entry->name[len] = '\0';
+    return entry;
+}
+
+/** Free the content of a node, or drop its reference to a shared blob. */
+static void fs_content_free(mem_pool_t *pool, fs_entry_t *entry) {
+    if (entry->capacity > 0) {
+        mem_pool_free(pool, entry->content, entry->capacity);
+    } else if (entry->content) {
+        blob_unref(blob_from_data(entry->content));
+    }
+    entry->content = NULL;
+    entry->size = entry->capacity = 0;
+}
+
+/** A new reference to the content of a non-empty entry as a blob, or NULL
+ *  if memory is exhausted. */
+static blob_t *fs_content_blob(const fs_entry_t *entry) {
+    if (entry->capacity == 0) {
+        blob_t *blob = blob_from_data(entry->content);
+        blob_ref(blob);
+        return blob;
+    }
+    return blob_intern(entry->content, entry->size);
+}
+
+/** Make a blob the content of a node, taking over the reference. */
+static void fs_content_share(mem_pool_t *pool, fs_entry_t *entry, blob_t *blob) {
+    fs_content_free(pool, entry);
+    entry->content = blob->data;
+    entry->size = blob->size;
+}
+
+/** A new reference to the content of a non-empty entry for a copy of it,
+ *  or NULL if memory is exhausted. Private content of an overlay entry
+ *  moves into the store too, so further copies are a reference each. */
+static blob_t *fs_copy_blob(fs_entry_t *source) {
+    vfs_t *fs = current_fs();
+    blob_t *blob = fs_content_blob(source);
+    if (blob && source->capacity > 0 && !source->shared) {
+        blob_ref(blob);
+        fs_content_share(&fs->pool, source, blob);
+    }
+    return blob;
+}
+
+/** Free a node together with its name and content. */
+static void fs_entry_free(fs_entry_t *entry) {
+    vfs_t *fs = current_fs();
+    mem_pool_free(&fs->pool, entry->name, strlen(entry->name) + 1);
+    fs_content_free(&fs->pool, entry);
+    slab_free(&fs->entries, entry);
+}
+
+/** Append a node to its parent's child list. */
+static void fs_link_child(fs_entry_t *parent, fs_entry_t *entry) {
+    entry->parent = parent;
+    entry->prev_sibling = parent->last_child;
+    entry->next_sibling = NULL;
+    if (parent->last_child) {
+        parent->last_child->next_sibling = entry;
+    } else {
+        parent->first_child = entry;
+    }
+    parent->last_child = entry;
+    parent->child_count++;
+    parent->version++;
+}
+
+/** Unlink a node from its parent's child list. */
+static void fs_unlink_child(fs_entry_t *entry) {
+    fs_entry_t *parent = entry->parent;
+    if (entry->prev_sibling) {
+        entry->prev_sibling->next_sibling = entry->next_sibling;
+    } else {
+        parent->first_child = entry->next_sibling;
+    }
+    if (entry->next_sibling) {
+        entry->next_sibling->prev_sibling = entry->prev_sibling;
+    } else {
+        parent->last_child = entry->prev_sibling;
+    }
+    parent->child_count--;
+    parent->version++;
+}
+
+/** Free the whiteouts below a copied directory that is going away: they
+ *  are keyed on its inode number, which nothing can reach after it. */
+static void fs_drop_whiteouts(const fs_entry_t *dir) {
+    vfs_t *fs = current_fs();
+    for (fs_entry_t *lower = dir->lower->first_child; lower; lower = lower->next_sibling) {
+        fs_entry_t *node = fs_index_get(fs, dir->ino, lower->name, strlen(lower->name), lower->hash);
+        if (node && node->whiteout) {
+            fs_table_remove(&fs->index, node);
+            fs_entry_free(node);
+        }
+    }
+}
+
+/** Is a base entry at or below another? */
+static bool fs_lower_within(const fs_entry_t *entry, const fs_entry_t *lower) {
+    for (; entry; entry = entry->parent) {
+        if (entry == lower) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/** Clear the watched slots holding an entry that is going away, or a base
+ *  entry that goes with it: the one it is a copy of, or one below that. */
+static void fs_unwatch(const fs_entry_t *entry) {
+    vfs_t *fs = current_fs();
+    const fs_entry_t *lower = entry->shared ? entry : entry->lower;
+    for (int i = 0; i < VFS_MAX_WATCHES && fs->watches[i]; i++) {
+        fs_entry_t *watched = *fs->watches[i];
+        if (watched && (watched == entry || (lower && watched->shared &&
+                                             fs_lower_within(watched, lower)))) {
+            *fs->watches[i] = NULL;
+        }
+    }
+}
+
+/** Drop a childless node from its parent and free it. A node under the
+ *  name of a base entry stays in the index as its whiteout. */
+static void fs_entry_release(fs_entry_t *entry) {
+    vfs_t *fs = current_fs();
+    fs_unwatch(entry);
+    if (entry->lower) {
+        fs_drop_whiteouts(entry);
+        fs_table_remove(&fs->copies, entry);
+        entry->lower = NULL;
+        entry->moved = false;
+    }
+    if (entry->parent) {
+        fs_unlink_child(entry);
+    } else {
+        fs->root = NULL;
+    }
+    if (fs->base && fs_index_get(fs->base, fs_parent_ino(entry), entry->name,
+                                 strlen(entry->name), entry->hash)) {
+        // The parent stays: it is part of the key
+        fs_content_free(&fs->pool, entry);
+        entry->whiteout = true;
+        entry->first_child = entry->last_child = NULL;
+        entry->prev_sibling = entry->next_sibling = NULL;
+        entry->child_count = 0;
+        return;
+    }
+    fs_table_remove(&fs->index, entry);
+    fs_entry_free(entry);
+}
+
+/** Release an overlay node and the overlay nodes below it. */
+static void fs_release_tree(fs_entry_t *top) {
+    // Post-order walk: descend to a leaf, release it, continue from its
+    // parent. Every node is visited once and released in O(1), but for a
+    // copied directory, which looks for its whiteouts once.
+    fs_entry_t *node = top;
+    for (;;) {
+        while (node->first_child) {
+            node = node->first_child;
+        }
+        fs_entry_t *parent = node->parent;
+        bool last = node == top;
+        fs_entry_release(node);
+        if (last) {
+            break;
+        }
+        node = parent;
+    }
+}
+
+/** Add a whiteout in directory parent hiding a base entry. Returns 0, or
+ *  -1 with errno set to ENOMEM. */
+static int fs_add_whiteout(fs_entry_t *parent, const fs_entry_t *lower) {
+    vfs_t *fs = current_fs();
+    if (!fs_table_reserve(&fs->index, 1)) {
+        errno = ENOMEM;
+        return -1;
+    }
+    fs_entry_t *whiteout = fs_entry_alloc(lower->name, strlen(lower->name));
+    if (!whiteout) {
+        errno = ENOMEM;
+        return -1;
+    }
+    whiteout->whiteout = true;
+    whiteout->parent = parent;
+    whiteout->hash = lower->hash;
+    fs_table_insert(&fs->index, whiteout);
+    parent->version++;
+    return 0;
+}
+
+/**
+ * The overlay node to write to in place of an entry: the entry itself, or
+ * for a base entry its copy, made on first use together with the copies
+ * of its ancestors. Returns NULL with errno set to ENOMEM, ENOENT for a
+ * removed entry, or EROFS when there is no overlay to write to.
+ */
+static fs_entry_t *fs_writable(fs_entry_t *entry) {
+    vfs_t *fs = current_fs();
+    if (!entry->shared) {
+        return entry;
+    }
+    if (!fs->base) {
+        errno = EROFS;
+        return NULL;
+    }
+    fs_entry_t *copy = fs_copy_of(entry->ino);
+    if (copy) {
+        return copy;
+    }
+    if (fs_cover_of(entry)) {
+        errno = ENOENT;
+        return NULL;
+    }
+
+    fs_entry_t *parent = NULL;
+    if (entry->parent && !(parent = fs_writable(entry->parent))) {
+        return NULL;
+    }
+    if (!fs_table_reserve(&fs->index, 1) || !fs_table_reserve(&fs->copies, 1)) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    copy = fs_entry_alloc(entry->name, strlen(entry->name));
+    if (!copy) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    blob_t *blob = entry->size > 0 ? fs_content_blob(entry) : NULL;
+    if (entry->size > 0 && !blob) {
+        fs_entry_free(copy);
+        errno = ENOMEM;
+        return NULL;
+    }
+    if (blob) {
+        fs_content_share(&fs->pool, copy, blob);
+    }
+    // Same parent inode and name as the base entry, so the same hash
+    copy->hash = entry->hash;
+    copy->is_dir = entry->is_dir;
+    copy->lower = entry;
+    copy->created = entry->created;
+    copy->modified = entry->modified;
+    copy->ino = entry->ino;
+    copy->version = entry->version;
+    if (parent) {
+        fs_link_child(parent, copy);
+        parent->child_count--;      // the base entry was counted already
+    } else {
+        fs->root = copy;
+    }
+    copy->child_count = entry->child_count;
+    fs_table_insert(&fs->index, copy);
+    fs_table_insert(&fs->copies, copy);
+    return copy;
+}
+
+/** The next own child from entry on, skipping copies in place: those come
+ *  in the order of their base entries. */
+static fs_entry_t *fs_next_own(fs_entry_t *entry) {
+    while (entry && fs_in_place(entry)) {
+        entry = entry->next_sibling;
+    }
+    return entry;
+}
+
+/** The first of a base entry and its later siblings still shown in the
+ *  copied directory dir, as its copy if it has one. Those removed, moved
+ *  away or replaced since are skipped. */
+static fs_entry_t *fs_next_lower(const fs_entry_t *dir, fs_entry_t *lower) {
+    vfs_t *fs = current_fs();
+    for (; lower; lower = lower->next_sibling) {
+        fs_entry_t *node = fs_index_get(fs, dir->ino, lower->name, strlen(lower->name), lower->hash);
+        if (!node) {
+            return lower;
+        }
+        if (node->lower == lower && !node->moved) {
+            return node;
+        }
+    }
+    return NULL;
+}
+
+vfs_t *vfs_new(void) {
+    vfs_t *vfs = calloc(1, sizeof(vfs_t));
+    if (vfs) {
+        vfs->copies.by_ino = true;
+    }
+    return vfs;
+}
+
+vfs_t *vfs_new_overlay(const vfs_t *base) {
+    vfs_t *vfs = vfs_new();
+    if (vfs) {
+        vfs->base = vfs->origin = base;
+        vfs->visible = base->visible;
+        vfs->next_ino = base->next_ino;
+    }
+    return vfs;
+}
+
+void vfs_freeze(vfs_t *vfs) {
+    for (unsigned int i = 0; i < vfs->index.capacity; i++) {
+        fs_entry_t *entry = vfs->index.slots[i];
+        if (!entry) {
+            continue;
+        }
+        // Content moves to the store so copies in overlays can share it;
+        // if the store is out of memory it stays private and is interned
+        // by each copy instead
+        blob_t *blob = entry->capacity > 0 ? blob_intern(entry->content, entry->size) : NULL;
+        if (blob) {
+            fs_content_share(&vfs->pool, entry, blob);
+        }
+        entry->shared = true;
+    }
+    vfs->frozen = true;
+}
+
+void vfs_delete(vfs_t *vfs) {
+    if (!vfs) {
+        return;
+    }
+    if (bound_fs == vfs) {
+        bound_fs = NULL;
+    }
+    // Every node is in the index; free the buffers that were malloc'd on
+    // their own, the rest goes with the slabs
+    for (unsigned int i = 0; i < vfs->index.capacity; i++) {
+        fs_entry_t *entry = vfs->index.slots[i];
+        if (entry) {
+            mem_pool_free(&vfs->pool, entry->name, strlen(entry->name) + 1);
+            fs_content_free(&vfs->pool, entry);
+        }
+    }
+    free(vfs->index.slots);
+    free(vfs->copies.slots);
+    slab_destroy(&vfs->entries);
+    mem_pool_destroy(&vfs->pool);
+    free(vfs);
+}
+
+vfs_t *vfs_use(vfs_t *vfs) {
+    vfs_t *previous = bound_fs;
+    bound_fs = vfs;
+    return previous;
+}
+
+int vfs_watch(vfs_t *vfs, fs_entry_t **slot) {
+    for (int i = 0; i < VFS_MAX_WATCHES; i++) {
+        if (!vfs->watches[i]) {
+            vfs->watches[i] = slot;
+            return 0;
+        }
+    }
+    errno = ENOSPC;
+    return -1;
+}
+
+void vfs_unwatch(vfs_t *vfs, fs_entry_t **slot) {
+    // The watched slots stay a prefix of the array: the last one fills
+    // the gap
+    int last = 0;
+    while (last < VFS_MAX_WATCHES && vfs->watches[last]) {
+        last++;
+    }
+    for (int i = 0; i < last; i++) {
+        if (vfs->watches[i] == slot) {
+            vfs->watches[i] = vfs->watches[last - 1];
+            vfs->watches[last - 1] = NULL;
+            return;
+        }
+    }
+}
+
+fs_entry_t *fs_root(void) {
+    vfs_t *fs = current_fs();
+    if (fs->root) {
+        return fs->root;
+    }
+    return fs->base ? fs->base->root : NULL;
+}
+
+fs_entry_t *fs_parent(const fs_entry_t *entry) {
+    fs_entry_t *parent = entry->parent;
+    return parent && parent->shared ? fs_visible(parent) : parent;
+}
+
+fs_entry_t *fs_first_child(fs_entry_t *dir) {
+    dir = fs_visible(dir);
+    if (!dir) {
+        return NULL;
+    }
+    if (dir->shared) {
+        return dir->first_child;
+    }
+    fs_entry_t *child = dir->lower ? fs_next_lower(dir, dir->lower->first_child) : NULL;
+    return child ? child : fs_next_own(dir->first_child);
+}
+
+fs_entry_t *fs_next_sibling(fs_entry_t *entry) {
+    vfs_t *fs = current_fs();
+    if (!fs->base) {
+        return entry->next_sibling;
+    }
+    fs_entry_t *lower, *parent;
+    if (entry->shared) {
+        lower = entry;
+        parent = fs_parent(entry);
+    } else if (fs_in_place(entry)) {
+        lower = entry->lower;
+        parent = entry->parent;
+    } else {
+        return fs_next_own(entry->next_sibling);
+    }
+    if (!parent) {
+        return NULL;
+    }
+    if (parent->shared) {
+        return lower->next_sibling;     // nothing below it changed
+    }
+    // Past the base entries come the ones created in the overlay
+    fs_entry_t *next = fs_next_lower(parent, lower->next_sibling);
+    return next ? next : fs_next_own(parent->first_child);
+}
+
+/** Is a component (the first len bytes of name) "." or ".."? */
+static bool fs_is_dot(const char *name, size_t len) {
+    return name[0] == '.' && (len == 1 || (len == 2 && name[1] == '.'));
+}
+
+/** Take one step of a path from a directory: to itself for ".", to its
+ *  parent for ".." (the root is its own parent), else to its entry with
+ *  that name. NULL if dir is not a directory or has no such entry. */
+static fs_entry_t *fs_step(fs_entry_t *dir, const char *name, size_t len) {
+    if (!dir->is_dir) {
+        return NULL;
+    }
+    if (!fs_is_dot(name, len)) {
+        return fs_lookup(dir, name, len);
+    }
+    fs_entry_t *parent = len == 2 ? fs_parent(dir) : NULL;
+    return parent ? parent : dir;
+}
+
+fs_entry_t *fs_resolve_parent(fs_entry_t *dir, const char *path, const char **name, size_t *len) {
+    // A directory kept by the caller may have been copied or moved since
+    dir = path[0] == '/' ? fs_root() : dir ? fs_visible(dir) : NULL;
+    const char *component = path;
+    while (dir) {
+        while (*component == '/') {
+            component++;
+        }
+        size_t n = strcspn(component, "/");
+        const char *next = component + n;
+        while (*next == '/') {
+            next++;
+        }
+        if (*next == '\0' && !fs_is_dot(component, n)) {
+            *name = component;
+            *len = n;
+            return dir;
+        }
+        dir = fs_step(dir, component, n);
+        component = next;
+    }
+    return NULL;
+}
+
+fs_entry_t *fs_resolve(fs_entry_t *dir, const char *path) {
+    const char *name;
+    size_t len;
+    dir = fs_resolve_parent(dir, path, &name, &len);
+    if (!dir || len == 0) {
+        return dir;
+    }
+    return dir->is_dir ? fs_lookup(dir, name, len) : NULL;
+}
+
+fs_entry_t *fs_find_parent(const char *path, const char **name, size_t *len) {
+    return fs_resolve_parent(NULL, path, name, len);
+}
+
+fs_entry_t *find_fs_entry(const char *path) {
+    return fs_resolve(NULL, path);
+}
+
+/** A new node named by the first len bytes of name in a writable
+ *  directory (NULL for the root), not yet counted or journaled. Returns
+ *  NULL with errno set to ENOMEM. */
+static fs_entry_t *fs_new_node(fs_entry_t *parent, const char *name, size_t len, bool is_dir) {
+    vfs_t *fs = current_fs();
+    if (!fs_table_reserve(&fs->index, 1)) {
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    // A new entry under the name of a removed base entry reuses its
+    // whiteout. It is not a copy: it comes after the base entries and
+    // shows none of those that were below the removed one.
+    unsigned long parent_ino = parent ? parent->ino : 0;
+    unsigned int hash = fs_name_hash(parent_ino, name, len);
+    fs_entry_t *entry = fs->base ? fs_index_get(fs, parent_ino, name, len, hash) : NULL;
+    if (entry) {
+        entry->whiteout = false;
+    } else if (!(entry = fs_entry_alloc(name, len))) {
+        errno = ENOMEM;
+        return NULL;
+    } else {
+        entry->hash = hash;
+        fs_table_insert(&fs->index, entry);
+    }
+    entry->is_dir = is_dir;
+    entry->created = time(NULL);
+    entry->modified = entry->created;
+    entry->ino = ++fs->next_ino;
+    entry->version = 0;
+
+    if (parent) {
+        fs_link_child(parent, entry);
+    } else {
+        fs->root = entry;
+    }
+    return entry;
+}
+
+fs_entry_t *fs_add_child(fs_entry_t *dir, const char *name, size_t len, bool is_dir) {
+    vfs_t *fs = current_fs();
+    if (fs->frozen) {
+        errno = EROFS;
+        return NULL;
+    }
+    if (!dir->is_dir) {
+        errno = ENOTDIR;
+        return NULL;
+    }
+    if (fs_lookup(dir, name, len)) {
+        errno = EEXIST;
+        return NULL;
+    }
+    fs_entry_t *entry;
+    if (!(dir = fs_writable(dir)) || !(entry = fs_new_node(dir, name, len, is_dir))) {
+        return NULL;
+    }
+    fs->visible++;
+    journal_record(JOURNAL_CREATE, entry, is_dir ? JOURNAL_DIR : 0, NULL, 0);
+    return entry;
+}
+
+fs_entry_t *add_fs_entry(const char *path, bool is_dir) {
+    vfs_t *fs = current_fs();
+    if (fs->frozen) {
+        errno = EROFS;
+        return NULL;
+    }
+    const char *name;
+    size_t len;
+    fs_entry_t *parent = fs_find_parent(path, &name, &len);
+    if (parent && len > 0) {
+        return fs_add_child(parent, name, len, is_dir);
+    }
+    if (parent) {
+        errno = EEXIST;
+        return NULL;
+    }
+    if (path[0] != '/' || path[strspn(path, "/")] != '\0') {
+        errno = ENOENT;
+        return NULL;
+    }
+
+    fs_entry_t *root = fs_new_node(NULL, "/", 1, is_dir);
+    if (!root) {
+        return NULL;
+    }
+    fs->visible++;
+    journal_record(JOURNAL_CREATE, root, is_dir ? JOURNAL_DIR : 0, NULL, 0);
+    return root;
+}
+
+/** Hide a base entry that has no overlay node, for removing it. */
+static int fs_remove_lower(fs_entry_t *entry) {
+    fs_entry_t *parent = fs_writable(entry->parent);
+    if (!parent || fs_add_whiteout(parent, entry) != 0) {
+        return -1;
+    }
+    fs_unwatch(entry);
+    parent->child_count--;
+    return 0;
+}
+
+int remove_fs_entry(fs_entry_t *entry) {
+    vfs_t *fs = current_fs();
+    if (!(entry = fs_visible(entry))) {
+        errno = ENOENT;
+        return -1;
+    }
+    if (!entry->parent) {
+        errno = EBUSY;
+        return -1;
+    }
+    if (fs_first_child(entry)) {
+        errno = ENOTEMPTY;
+        return -1;
+    }
+
+    if (entry->shared) {
+        if (fs_remove_lower(entry) != 0) {
+            return -1;
+        }
+        fs->visible--;
+        journal_record(JOURNAL_REMOVE, entry, 0, NULL, 0);
+        return 0;
+    }
+    journal_record(JOURNAL_REMOVE, entry, 0, NULL, 0);
+    fs_entry_release(entry);
+    fs->visible--;
+    return 0;
+}
+
+/** The entry after node in a pre-order walk of the subtree of top, or
+ *  NULL. */
+static fs_entry_t *fs_next_in_subtree(fs_entry_t *node, const fs_entry_t *top) {
+    fs_entry_t *child = fs_first_child(node);
+    if (child) {
+        return child;
+    }
+    for (; node != top; node = fs_parent(node)) {
+        fs_entry_t *sibling = fs_next_sibling(node);
+        if (sibling) {
+            return sibling;
+        }
+    }
+    return NULL;
+}
+
+/** The number of entries in the subtree of a visible entry. */
+static unsigned int fs_subtree_size(fs_entry_t *top) {
+    unsigned int size = 0;
+    for (fs_entry_t *node = top; node; node = fs_next_in_subtree(node, top)) {
+        size++;
+    }
+    return size;
+}
+
+int remove_fs_tree(fs_entry_t *entry) {
+    vfs_t *fs = current_fs();
+    if (!(entry = fs_visible(entry))) {
+        errno = ENOENT;
+        return -1;
+    }
+    if (!entry->parent) {
+        errno = EBUSY;
+        return -1;
+    }
+
+    unsigned int size = fs_subtree_size(entry);
+    journal_record(JOURNAL_REMOVE, entry, JOURNAL_RECURSIVE, NULL, 0);
+    // Nothing below a base entry that is not copied has changed, and
+    // nothing there can be reached once it is whited out
+    if (entry->shared) {
+        if (fs_remove_lower(entry) != 0) {
+            return -1;
+        }
+    } else {
+        fs_release_tree(entry);
+    }
+    fs->visible -= size;
+    return 0;
+}
+
+/** Is node at or below entry? Both must be visible. */
+static bool fs_is_within(const fs_entry_t *node, const fs_entry_t *entry) {
+    for (; node; node = fs_parent(node)) {
+        if (node == entry) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/** The absolute path of an entry in a new buffer, or NULL if memory is
+ *  exhausted. */
+static char *fs_path_dup(const fs_entry_t *entry) {
+    size_t len = fs_entry_path(entry, NULL, 0);
+    char *path = malloc(len + 1);
+    if (path) {
+        fs_entry_path(entry, path, len + 1);
+    }
+    return path;
+}
+
+int fs_rename(fs_entry_t *entry, fs_entry_t *dir, const char *name, size_t len) {
+    vfs_t *fs = current_fs();
+    if (fs->frozen) {
+        errno = EROFS;
+        return -1;
+    }
+    if (!(entry = fs_visible(entry)) || !(dir = fs_visible(dir))) {
+        errno = ENOENT;
+        return -1;
+    }
+    if (!entry->parent) {
+        errno = EBUSY;
+        return -1;
+    }
+    if (!dir->is_dir) {
+        errno = ENOTDIR;
+        return -1;
+    }
+    if (fs_is_within(dir, entry)) {
+        errno = EINVAL;
+        return -1;
+    }
+    fs_entry_t *target = fs_lookup(dir, name, len);
+    if (target == entry) {
+        return 0;
+    }
+    if (target && target->is_dir != entry->is_dir) {
+        errno = target->is_dir ? EISDIR : ENOTDIR;
+        return -1;
+    }
+    if (target && fs_first_child(target)) {
+        errno = ENOTEMPTY;
+        return -1;
+    }
+
+    // Everything that can fail comes before the target goes, so a failed
+    // rename leaves both names as they were
+    char *from = journal_recording() ? fs_path_dup(entry) : NULL;
+    if (journal_recording() && !from) {
+        errno = ENOMEM;
+        return -1;
+    }
+    if (!(dir = fs_writable(dir)) || !(entry = fs_writable(entry))) {
+        free(from);
+        return -1;
+    }
+    // A base entry under the old name is hidden from now on
+    fs_entry_t *parent = entry->parent;
+    size_t old_len = strlen(entry->name);
+    const fs_entry_t *lower = fs->base ? fs_index_get(fs->base, parent->ino, entry->name, old_len,
+                                                      entry->hash) : NULL;
+    bool renamed = old_len != len || strncmp(entry->name, name, len) != 0;
+    char *new_name = renamed ? mem_pool_alloc(&fs->pool, len + 1) : entry->name;
+    if (!new_name || (lower && fs_add_whiteout(parent, lower) != 0)) {
+        if (renamed && new_name) {
+            mem_pool_free(&fs->pool, new_name, len + 1);
+        }
+        free(from);
+        errno = ENOMEM;
+        return -1;
+    }
+
+    if (target) {
+        journal_record(JOURNAL_REMOVE, target, 0, NULL, 0);
+        if (target->shared) {
+            // No whiteout needed: the entry takes the name in the overlay
+            fs_unwatch(target);
+            dir->child_count--;
+        } else {
+            fs_entry_release(target);
+        }
+        fs->visible--;
+    }
+    fs_table_remove(&fs->index, entry);
+    fs_unlink_child(entry);
+    // The entry takes over from a whiteout under the new name
+    unsigned int hash = fs_name_hash(dir->ino, name, len);
+    fs_entry_t *whiteout = fs_index_get(fs, dir->ino, name, len, hash);
+    if (whiteout) {
+        fs_table_remove(&fs->index, whiteout);
+        fs_entry_free(whiteout);
+    }
+    if (renamed) {
+        mem_pool_free(&fs->pool, entry->name, old_len + 1);
+        memcpy(new_name, name, len);
+        new_name[len] = '\0';
+        entry->name = new_name;
+    }
+    entry->hash = hash;
+    entry->moved = entry->lower != NULL;
+    fs_link_child(dir, entry);
+    fs_table_insert(&fs->index, entry);
+
+    journal_record(JOURNAL_RENAME, entry, 0, from, from ? strlen(from) : 0);
+    free(from);
+    return 0;
+}
+
+/** A new node like source named by the first len bytes of name in a
+ *  writable directory, sharing its content. Returns NULL with errno set
+ *  to ENOMEM. */
+static fs_entry_t *fs_clone_node(fs_entry_t *source, fs_entry_t *parent, const char *name,
+                                 size_t len, time_t when) {
+    vfs_t *fs = current_fs();
+    blob_t *blob = source->size > 0 ? fs_copy_blob(source) : NULL;
+    if (source->size > 0 && !blob) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    fs_entry_t *node = fs_new_node(parent, name, len, source->is_dir);
+    if (!node) {
+        if (blob) {
+            blob_unref(blob);
+        }
+        return NULL;
+    }
+    if (blob) {
+        fs_content_share(&fs->pool, node, blob);
+    }
+    node->created = node->modified = when;
+    return node;
+}
+
+fs_entry_t *fs_copy_tree(fs_entry_t *entry, fs_entry_t *dir, const char *name, size_t len,
+                         time_t when) {
+    vfs_t *fs = current_fs();
+    if (fs->frozen) {
+        errno = EROFS;
+        return NULL;
+    }
+    if (!(entry = fs_visible(entry)) || !(dir = fs_visible(dir))) {
+        errno = ENOENT;
+        return NULL;
+    }
+    if (!dir->is_dir) {
+        errno = ENOTDIR;
+        return NULL;
+    }
+    if (fs_is_within(dir, entry)) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (fs_lookup(dir, name, len)) {
+        errno = EEXIST;
+        return NULL;
+    }
+    if (!(dir = fs_writable(dir))) {
+        return NULL;
+    }
+
+    // All the nodes in one go, so the copy allocates little more than the
+    // names; the content is shared
+    unsigned int size = fs_subtree_size(entry);
+    if (slab_reserve(fs_slab(), size) != 0 || !fs_table_reserve(&fs->index, size)) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    fs_entry_t *top = fs_clone_node(entry, dir, name, len, when);
+    if (!top) {
+        return NULL;
+    }
+
+    // Pre-order walk of the original, with at the copy of node
+    fs_entry_t *node = entry, *at = top;
+    for (;;) {
+        fs_entry_t *parent = at;
+        fs_entry_t *next = fs_first_child(node);
+        if (!next) {
+            while (node != entry && !(next = fs_next_sibling(node))) {
+                node = fs_parent(node);
+                at = at->parent;
+            }
+            if (!next) {
+                break;
+            }
+            parent = at->parent;
+        }
+        node = next;
+        at = fs_clone_node(node, parent, node->name, strlen(node->name), when);
+        if (!at) {
+            fs_release_tree(top);
+            return NULL;
+        }
+    }
+    fs->visible += size;
+
+    if (journal_recording()) {
+        char *from = fs_path_dup(entry);
+        if (from) {
+            journal_record(JOURNAL_COPY, top, 0, from, strlen(from));
+            free(from);
+        } else {
+            journal_mark_lost();
+        }
+    }
+    return top;
+}
+
+void fs_clear(void) {
+    vfs_t *fs = current_fs();
+    // Not journaled as such: whoever replaces the whole filesystem starts
+    // a new base (see snapshot_load)
+    if (fs->frozen) {
+        return;
+    }
+    for (unsigned int i = 0; i < fs->index.capacity; i++) {
+        if (fs->index.slots[i]) {
+            fs_entry_free(fs->index.slots[i]);
+            fs->index.slots[i] = NULL;
+        }
+    }
+    if (fs->copies.capacity > 0) {
+        memset(fs->copies.slots, 0, fs->copies.capacity * sizeof(fs_entry_t *));
+    }
+    fs->index.count = fs->copies.count = 0;
+    for (int i = 0; i < VFS_MAX_WATCHES && fs->watches[i]; i++) {
+        *fs->watches[i] = NULL;
+    }
+    fs->root = NULL;
+    fs->base = NULL;
+    fs->visible = 0;
+}
+
+void fs_revert(void) {
+    vfs_t *fs = current_fs();
+    fs_clear();
+    if (!fs->frozen && fs->origin) {
+        fs->base = fs->origin;
+        fs->visible = fs->origin->visible;
+    }
+}
+
+const char *fs_entry_content(const fs_entry_t *entry) {
+    return entry->content ? entry->content : "";
+}
+
+int fs_set_content(fs_entry_t *entry, const char *data, size_t len) {
+    vfs_t *fs = current_fs();
+    if (!(entry = fs_writable(entry))) {
+        return -1;
+    }
+    if (len == 0) {
+        fs_content_free(&fs->pool, entry);
+        entry->version++;
+        journal_record(JOURNAL_WRITE, entry, 0, NULL, 0);
+        return 0;
+    }
+
+    if (len >= VFS_SHARE_MIN) {
+        blob_t *blob = blob_intern(data, len);
+        if (!blob) {
+            errno = ENOMEM;
+            return -1;
+        }
+        fs_content_share(&fs->pool, entry, blob);
+        entry->version++;
+        journal_record(JOURNAL_WRITE, entry, 0, entry->content, len);
+        return 0;
+    }
+
+    size_t capacity = mem_capacity(len + 1);
+    if (capacity != entry->capacity) {
+        char *content = mem_pool_alloc(&fs->pool, capacity);
+        if (!content) {
+            errno = ENOMEM;
+            return -1;
+        }
+        // data may be the old content, so copy before freeing it
+        memcpy(content, data, len);
+        fs_content_free(&fs->pool, entry);
+        entry->content = content;
+        entry->capacity = capacity;
+    } else {
+        memmove(entry->content, data, len);
+    }
+    entry->content[len] = '\0';
+    entry->size = len;
+    entry->version++;
+    journal_record(JOURNAL_WRITE, entry, 0, entry->content, len);
+    return 0;
+}
+
+int fs_append_content(fs_entry_t *entry, const char *data, size_t len) {
+    vfs_t *fs = current_fs();
+    if (!(entry = fs_writable(entry))) {
+        return -1;
+    }
+    size_t needed = entry->size + len + 1;
+    blob_t *shared = NULL;
+
+    if (needed > entry->capacity) {
+        // data may point into the content itself (a file appended to
+        // itself), so remember where before the buffer moves
+        bool inside = entry->content && data >= entry->content &&
+                      data < entry->content + entry->capacity;
+        size_t offset = inside ? (size_t)(data - entry->content) : 0;
+
+        // grow geometrically: the size classes stop doubling at
+        // MEM_MAX_CLASS, but appends must stay amortized O(1) beyond it
+        size_t capacity = entry->capacity ? entry->capacity * 2 : 0;
+        if (capacity < needed) {
+            capacity = needed;
+        }
+        capacity = mem_capacity(capacity);
+        // A shared blob is copied, not moved, and released once data
+        // (which may point into it) has been appended
+        char *content = entry->capacity
+                        ? mem_pool_realloc(&fs->pool, entry->content, entry->capacity, capacity)
+                        : mem_pool_alloc(&fs->pool, capacity);
+        if (!content) {
+            errno = ENOMEM;
+            return -1;
+        }
+        if (!entry->capacity && entry->content) {
+            shared = blob_from_data(entry->content);
+            memcpy(content, entry->content, entry->size);
+        }
+        entry->content = content;
+        entry->capacity = capacity;
+        if (inside) {
+            data = content + offset;
+        }
+    }
+    if (len > 0) {
+        memmove(entry->content + entry->size, data, len);
+    }
+    if (shared) {
+        blob_unref(shared);
+    }
+    entry->size += len;
+    entry->content[entry->size] = '\0';
+    entry->version++;
+    journal_record(JOURNAL_APPEND, entry, 0, entry->content + entry->size - len, len);
+    return 0;
+}
+
+int fs_share_content(fs_entry_t *entry, fs_entry_t *source) {
+    vfs_t *fs = current_fs();
+    if (!(source = fs_visible(source))) {
+        errno = ENOENT;
+        return -1;
+    }
+    if (source->size == 0) {
+        return fs_set_content(entry, NULL, 0);
+    }
+    if (!(entry = fs_writable(entry))) {
+        return -1;
+    }
+    blob_t *blob = fs_copy_blob(source);
+    if (!blob) {
+        errno = ENOMEM;
+        return -1;
+    }
+    fs_content_share(&fs->pool, entry, blob);
+    entry->version++;
+    journal_record(JOURNAL_WRITE, entry, 0, entry->content, entry->size);
+    return 0;
+}
+
+void fs_touch(fs_entry_t *entry, time_t modified) {
+    if (!(entry = fs_writable(entry))) {
+        return;
+    }
+    entry->modified = modified;
+    journal_record(JOURNAL_TOUCH, entry, 0, NULL, 0);
+}
+
+const char *fs_entry_basename(const fs_entry_t *entry) {
+    return entry->name;
+}
+
+size_t fs_entry_path(const fs_entry_t *entry, char *buf, size_t size) {
+    size_t len = 0;
+    for (const fs_entry_t *node = entry; node && node->parent; node = fs_parent(node)) {
+        len += 1 + strlen(node->name);
+    }
+    if (len == 0) {
+        len = 1;        // the root
+    }
+    if (len >= size) {
+        return len;
+    }
+
+    // Fill in the components from the end
+    size_t end = len;
+    buf[0] = '/';
+    buf[len] = '\0';
+    for (const fs_entry_t *node = entry; node && node->parent; node = fs_parent(node)) {
+        size_t n = strlen(node->name);
+        end -= n;
+        memcpy(buf + end, node->name, n);
+        buf[--end] = '/';
+    }
+    return len;
+}
+
+unsigned int fs_entry_count(void) {
+    vfs_t *fs = current_fs();
+    return fs->visible;
+}
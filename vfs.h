@@ -0,0 +1,212 @@
+#ifndef _VFS_H
+#define _VFS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <time.h>
+
+/**
+ * A node of the virtual filesystem tree. Every node keeps only its own
+ * name and a parent pointer, and paths are resolved through the tree one
+ * component at a time, so moving a directory changes its node alone.
+ * Directories keep a doubly linked list of their children in creation
+ * order.
+ *
+ * Nodes come from a slab and their name and content from a size-class
+ * pool (see alloc.h), both owned by the filesystem, so memory grows with
+ * what is actually stored. Content written whole or copied is kept in the
+ * process-wide blob store instead (see blob.h), once per distinct value.
+ *
+ * In an overlay (see vfs_new_overlay) the child links only hold the nodes
+ * of one layer, so walk a directory with fs_first_child and
+ * fs_next_sibling, and up the tree with fs_parent. Entries of a base image
+ * are shared by every overlay on it and must only be changed through the
+ * functions below.
+ */
+typedef struct fs_entry fs_entry_t;
+struct fs_entry {
+    char *name;                   /* Last path component, "/" for the root. */
+    unsigned int hash;            /* Cached hash of the parent and name, see vfs.c. */
+    bool is_dir;
+    bool shared;                  /* Part of a frozen base image. */
+    bool whiteout;                /* Overlay node hiding a base entry. */
+    bool moved;                   /* Copy renamed, listed as if created. */
+    fs_entry_t *lower;            /* Base entry an overlay copy stands for. */
+    char *content;                /* NUL-terminated, NULL while empty. */
+    size_t size;                  /* Bytes of content, excluding the NUL. */
+    size_t capacity;              /* Bytes reserved, 0 for a shared blob. */
+    time_t created;
+    time_t modified;
+    unsigned long ino;            /* Never reused within its filesystem. */
+    unsigned long version;        /* Bumped on every content change, and
+                                     for a directory whenever its
+                                     children do. */
+
+    fs_entry_t *parent;           /* NULL only for the root directory. */
+    fs_entry_t *first_child;      /* Children of a directory ... */
+    fs_entry_t *last_child;
+    unsigned int child_count;
+    fs_entry_t *prev_sibling;     /* ... linked through these. */
+    fs_entry_t *next_sibling;
+};
+
+/**
+ * A whole filesystem. Each thread works on one at a time, selected with
+ * vfs_use; every function below acts on it. There is no process-wide
+ * default: calling them with none selected is a bug, caught by an assert.
+ */
+typedef struct vfs vfs_t;
+
+/** A new filesystem without even a root, or NULL if memory is exhausted. */
+vfs_t *vfs_new(void);
+
+/** Free a filesystem and everything in it, without journaling. If it is
+ *  the calling thread's, the thread is left without one. */
+void vfs_delete(vfs_t *vfs);
+
+/**
+ * A new filesystem showing a frozen base image, or NULL if memory is
+ * exhausted. It stores only what changes: a base entry is copied when it
+ * (or something below it) is first written, sharing its content until
+ * that is replaced, and a removed one is hidden by a whiteout. Any number
+ * of overlays on any threads can share one base, which must outlive them.
+ */
+vfs_t *vfs_new_overlay(const vfs_t *base);
+
+/** Make a filesystem read-only, for use as the base of overlays. Writes
+ *  to it fail with EROFS from then on. */
+void vfs_freeze(vfs_t *vfs);
+
+/** Make vfs the calling thread's filesystem (NULL for none) and return
+ *  the previous one. */
+vfs_t *vfs_use(vfs_t *vfs);
+
+/**
+ * Have a filesystem watch a slot holding one of its entries across
+ * changes: the slot is set to NULL when the entry is removed, or the
+ * filesystem cleared. An entry that is moved stays valid, so a kept
+ * directory is followed wherever it goes. The slot must outlive the
+ * filesystem, or be unwatched first. Returns 0, or -1 with errno set to
+ * ENOSPC when the filesystem watches too many slots already.
+ */
+int vfs_watch(vfs_t *vfs, fs_entry_t **slot);
+
+/** Stop watching a slot; one that is not watched is ignored. */
+void vfs_unwatch(vfs_t *vfs, fs_entry_t **slot);
+
+/** The root directory, or NULL if it has not been created yet. */
+fs_entry_t *fs_root(void);
+
+/** The first child of a directory, or NULL. */
+fs_entry_t *fs_first_child(fs_entry_t *dir);
+
+/** The next child of the entry's directory, or NULL. Children come in
+ *  creation order, those of the base image first. */
+fs_entry_t *fs_next_sibling(fs_entry_t *entry);
+
+/** The directory holding an entry, or NULL for the root. */
+fs_entry_t *fs_parent(const fs_entry_t *entry);
+
+/**
+ * Find the entry at a path, absolute or relative to directory dir (NULL
+ * if there is none). The path is walked once, a component at a time,
+ * without being copied: empty components ("//") are skipped, "." stays
+ * and ".." goes up, so "a/../b" is "b". dir may be an entry kept from
+ * before a change (see vfs_watch). NULL if there is no such entry.
+ */
+fs_entry_t *fs_resolve(fs_entry_t *dir, const char *path);
+
+/** Find the entry that would hold the last component of a path, resolved
+ *  like fs_resolve, and point *name at that component and *len at its
+ *  length. *len is 0 when the path names the entry returned itself: the
+ *  root, or a path ending in "." or "..". NULL if a directory on the way
+ *  does not exist; the entry found may be a file. */
+fs_entry_t *fs_resolve_parent(fs_entry_t *dir, const char *path, const char **name, size_t *len);
+
+/** fs_resolve for an absolute path. */
+fs_entry_t *find_fs_entry(const char *path);
+
+/** fs_resolve_parent for an absolute path. */
+fs_entry_t *fs_find_parent(const char *path, const char **name, size_t *len);
+
+/** Create a new entry under its (existing) parent directory. Returns NULL
+ *  and sets errno to ENOMEM, ENOENT, ENOTDIR, EEXIST or EROFS on
+ *  failure. */
+fs_entry_t *add_fs_entry(const char *path, bool is_dir);
+
+/** Create a new entry named by the first len bytes of name in a directory,
+ *  failing like add_fs_entry. */
+fs_entry_t *fs_add_child(fs_entry_t *dir, const char *name, size_t len, bool is_dir);
+
+/** Unlink and free an entry. Returns 0, or -1 with errno set to ENOTEMPTY
+ *  for a non-empty directory, EBUSY for the root, or ENOMEM when an
+ *  overlay cannot record the removal. */
+int remove_fs_entry(fs_entry_t *entry);
+
+/** Unlink and free an entry together with everything below it, in time
+ *  proportional to the size of the subtree. Returns 0, or -1 with errno
+ *  set to EBUSY for the root or ENOMEM. */
+int remove_fs_tree(fs_entry_t *entry);
+
+/**
+ * Move an entry into directory dir under the first len bytes of name. Only
+ * the entry itself is relinked, however much lies below it. An entry
+ * already there is replaced as by rename(2): a file by a file, an empty
+ * directory by a directory, and only once nothing else can fail, so a
+ * failed rename changes nothing. Returns 0, or -1 with errno set to ENOENT,
+ * ENOTDIR, EISDIR, ENOTEMPTY, EINVAL for a move into the entry's own
+ * subtree, EBUSY for the root, EROFS or ENOMEM.
+ */
+int fs_rename(fs_entry_t *entry, fs_entry_t *dir, const char *name, size_t len);
+
+/**
+ * Copy an entry and everything below it into directory dir under the
+ * first len bytes of name, with the given creation and modification time.
+ * The nodes of the copy come from one allocation and share the content of
+ * the originals (see fs_share_content). Returns the copy, or NULL with
+ * errno set to ENOENT, ENOTDIR, EEXIST, EINVAL for a copy into the entry's
+ * own subtree, EROFS or ENOMEM.
+ */
+fs_entry_t *fs_copy_tree(fs_entry_t *entry, fs_entry_t *dir, const char *name, size_t len,
+                         time_t when);
+
+/** Free every entry, root included, leaving an empty filesystem that no
+ *  longer shows its base image. Unlike the other write paths this is not
+ *  journaled (see journal.h). */
+void fs_clear(void);
+
+/** Drop every change, going back to the base image (to an empty
+ *  filesystem if there is none). Not journaled either. */
+void fs_revert(void);
+
+/** The content of a file as a NUL-terminated string ("" when empty). */
+const char *fs_entry_content(const fs_entry_t *entry);
+
+/** Replace the content of a file. Returns 0, or -1 with errno set to
+ *  ENOMEM, or EROFS in a frozen filesystem. */
+int fs_set_content(fs_entry_t *entry, const char *data, size_t len);
+
+/** Append to the content of a file, growing its storage geometrically so a
+ *  sequence of appends costs amortized O(1) per byte. Returns 0, or -1 with
+ *  errno set to ENOMEM. */
+int fs_append_content(fs_entry_t *entry, const char *data, size_t len);
+
+/** Give a file the content of another, sharing the bytes through the blob
+ *  store (see blob.h) instead of copying them. Returns 0, or -1 with errno
+ *  set to ENOMEM. */
+int fs_share_content(fs_entry_t *entry, fs_entry_t *source);
+
+/** Set the modification time of an entry. */
+void fs_touch(fs_entry_t *entry, time_t modified);
+
+/** The last component of the entry's path ("/" for the root). */
+const char *fs_entry_basename(const fs_entry_t *entry);
+
+/** Write the absolute path of an entry and a NUL to buf if they fit in
+ *  size bytes. Returns the length of the path either way. */
+size_t fs_entry_path(const fs_entry_t *entry, char *buf, size_t size);
+
+/** The number of entries in the filesystem. */
+unsigned int fs_entry_count(void);
+
+#endif /* ifndef _VFS_H */
@@ -1,8 +1,13 @@
 #include "tokenize.h"
 #include "vect.h"
+#include "output.h"
+#include "shell.h"
+#include "snapshot.h"
+#include "journal.h"
 #include <stdio.h>
 #include <stdarg.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -11,32 +16,6 @@
 #define EMSCRIPTEN_KEEPALIVE __attribute__((used))
 #endif
 
-#define MAX_INPUT_SIZE 255
-#define MAX_OUTPUT_SIZE 4096
-
-// Global buffer for output
-static char g_output_buffer[MAX_OUTPUT_SIZE];
-static size_t g_output_pos = 0;
-
-// Custom printf that writes to our buffer
-EMSCRIPTEN_KEEPALIVE
-int custom_printf(const char* format, ...) {
-    va_list args;
-    va_start(args, format);
-    int result = vsnprintf(g_output_buffer + g_output_pos, 
-                          MAX_OUTPUT_SIZE - g_output_pos, 
-                          format, 
-                          args);
-    if (result > 0) {
-        g_output_pos += result;
-    }
-    va_end(args);
-    return result;
-}
-
-// Forward declaration
-void process_command(char* input, vect_t* args_vector);
-
 // Override stdin functions
 __attribute__((used))
 char* custom_gets(char* str) {
@@ -48,22 +27,340 @@ int custom_getchar(void) {
     return EOF;
 }
 
+/** The instance's shell session, created on first use and left current
+ *  for the module's only thread, so the output, journal and snapshot
+ *  functions below act on it. */
+static shell_session_t* instance(void) {
+    static shell_session_t* session = NULL;
+    if (!session) {
+        session = shell_session_new();
+        shell_session_use(session);
+    }
+    return session;
+}
+
+/** Argument vector kept for the lifetime of the instance and cleared after
+ *  every command, so commands do not pay for allocating one. */
+static vect_t* session_args(void) {
+    static vect_t* args = NULL;
+    if (!args) {
+        args = vect_new();
+    }
+    return args;
+}
+
+/**
+ * Run one command and return a pointer to its output. The output is also
+ * NUL-terminated, but JS can avoid the UTF8ToString copy by reading
+ * get_output_length() bytes straight out of the heap:
+ *
+ *   const ptr = Module._process_wasm_command(input);
+ *   const len = Module._get_output_length();
+ *   const bytes = Module.HEAPU8.subarray(ptr, ptr + len);
+ *
+ * The region stays valid until the next call into the shell.
+ */
 EMSCRIPTEN_KEEPALIVE
 const char* process_wasm_command(const char* input) {
     // Clear the output buffer
-    g_output_buffer[0] = '\0';
-    g_output_pos = 0;
+    shell_session_t* session = instance();
+    out_buf_t* out = output_buffer();
+    out_buf_reset(out);
     
     // Process the command
-    vect_t* args_vector = vect_new();
-    process_command((char*)input, args_vector);
-    vect_delete(args_vector);
+    vect_t* args_vector = session_args();
+    process_command(session, (char*)input, args_vector);
+    vect_clear(args_vector);
     
-    return g_output_buffer;
+    return out->data ? out->data : "";
+}
+
+/** Pointer to the output of the last command. */
+EMSCRIPTEN_KEEPALIVE
+const char* get_output_ptr(void) {
+    instance();
+    out_buf_t* out = output_buffer();
+    return out->data ? out->data : "";
+}
+
+/** Length in bytes of the output of the last command. */
+EMSCRIPTEN_KEEPALIVE
+size_t get_output_length(void) {
+    instance();
+    return output_buffer()->len;
+}
+
+/**
+ * Result of one command of a batch: where its output starts in the batch
+ * output, how long it is, and the command's exit status.
+ */
+typedef struct {
+    uint32_t offset;
+    uint32_t length;
+    int32_t status;
+} batch_result_t;
+
+static batch_result_t* g_batch_results = NULL;
+static size_t g_batch_count = 0;
+static size_t g_batch_capacity = 0;
+
+// Scratch copy of the current line, reused across lines and batches
+static char* g_batch_line = NULL;
+static size_t g_batch_line_capacity = 0;
+
+/** Make room for the results of count commands. */
+static bool batch_reserve(size_t count) {
+    if (count <= g_batch_capacity) {
+        return true;
+    }
+    size_t capacity = g_batch_capacity ? g_batch_capacity : 64;
+    while (capacity < count) {
+        capacity *= 2;
+    }
+    batch_result_t* results = realloc(g_batch_results, capacity * sizeof(batch_result_t));
+    if (!results) {
+        return false;
+    }
+    g_batch_results = results;
+    g_batch_capacity = capacity;
+    return true;
+}
+
+/** Record the result of one command, in room made by batch_reserve. */
+static void batch_add_result(size_t offset, size_t length, int status) {
+    g_batch_results[g_batch_count].offset = (uint32_t)offset;
+    g_batch_results[g_batch_count].length = (uint32_t)length;
+    g_batch_results[g_batch_count].status = status;
+    g_batch_count++;
+}
+
+/** The number of lines in a batch, a last one without '\n' included. */
+static size_t batch_line_count(const char* commands, size_t length) {
+    size_t count = 0;
+    for (size_t start = 0; start < length; count++) {
+        const char* newline = memchr(commands + start, '\n', length - start);
+        start = newline ? (size_t)(newline - commands) + 1 : length;
+    }
+    return count;
+}
+
+/**
+ * Run a newline-separated list of commands in one call. All output goes to
+ * a single region (returned, see get_output_length); get_batch_results()
+ * then describes each command in order, one entry per input line:
+ *
+ *   const out = Module._process_wasm_batch(buf, len);
+ *   const n = Module._get_batch_count();
+ *   const results = Module.HEAP32.subarray(
+ *       Module._get_batch_results() >> 2, (Module._get_batch_results() >> 2) + 3 * n);
+ *   // results[3*i] = offset, results[3*i+1] = length, results[3*i+2] = status
+ *
+ * The result table is sized for every line before any runs, so each line
+ * gets its entry: one that cannot be copied for lack of memory is not run
+ * and reports "shell: out of memory" with status 1. If even the table
+ * cannot be allocated, nothing runs and the return value is NULL (0 in
+ * JavaScript), with get_batch_count() 0.
+ */
+EMSCRIPTEN_KEEPALIVE
+const char* process_wasm_batch(const char* commands, size_t length) {
+    shell_session_t* session = instance();
+    out_buf_t* out = output_buffer();
+    out_buf_reset(out);
+    g_batch_count = 0;
+    if (!batch_reserve(batch_line_count(commands, length))) {
+        return NULL;
+    }
+
+    vect_t* args_vector = session_args();
+    size_t start = 0;
+    while (start < length) {
+        const char* newline = memchr(commands + start, '\n', length - start);
+        size_t end = newline ? (size_t)(newline - commands) : length;
+        size_t line_length = end - start;
+        if (line_length > 0 && commands[end - 1] == '\r') {
+            line_length--;
+        }
+        const char* text = commands + start;
+        start = end + 1;
+
+        size_t offset = out->len;
+        if (line_length + 1 > g_batch_line_capacity) {
+            size_t capacity = g_batch_line_capacity ? g_batch_line_capacity : 256;
+            while (capacity < line_length + 1) {
+                capacity *= 2;
+            }
+            char* line = realloc(g_batch_line, capacity);
+            if (!line) {
+                custom_printf("shell: out of memory\n");
+                batch_add_result(offset, out->len - offset, SHELL_STATUS_ERROR);
+                continue;
+            }
+            g_batch_line = line;
+            g_batch_line_capacity = capacity;
+        }
+        memcpy(g_batch_line, text, line_length);
+        g_batch_line[line_length] = '\0';
+
+        int status = process_command(session, g_batch_line, args_vector);
+        vect_clear(args_vector);
+        batch_add_result(offset, out->len - offset, status);
+    }
+
+    return out->data ? out->data : "";
+}
+
+/** Per-command results of the last batch, see process_wasm_batch. */
+EMSCRIPTEN_KEEPALIVE
+const batch_result_t* get_batch_results(void) {
+    return g_batch_results;
+}
+
+/** Number of commands in the last batch. */
+EMSCRIPTEN_KEEPALIVE
+size_t get_batch_count(void) {
+    return g_batch_count;
+}
+
+static char* g_snapshot = NULL;
+static size_t g_snapshot_length = 0;
+
+/**
+ * Serialize the filesystem into one binary image and return a pointer to
+ * it, for JS to keep (e.g. in IndexedDB) as a single Uint8Array:
+ *
+ *   const ptr = Module._get_snapshot();
+ *   const image = Module.HEAPU8.slice(ptr, ptr + Module._get_snapshot_length());
+ *
+ * The image becomes the new base of the journal: records from before it
+ * are dropped. It stays valid until the next call to get_snapshot.
+ */
+EMSCRIPTEN_KEEPALIVE
+const char* get_snapshot(void) {
+    instance();
+    free(g_snapshot);
+    g_snapshot_length = snapshot_size();
+    g_snapshot = malloc(g_snapshot_length);
+    if (!g_snapshot || snapshot_write(g_snapshot) == 0) {
+        free(g_snapshot);
+        g_snapshot = NULL;
+        g_snapshot_length = 0;
+    } else {
+        journal_reset();
+    }
+    return g_snapshot;
+}
+
+/** Length in bytes of the image returned by get_snapshot. */
+EMSCRIPTEN_KEEPALIVE
+size_t get_snapshot_length(void) {
+    return g_snapshot_length;
+}
+
+/**
+ * Replace the filesystem with an image from get_snapshot. Returns 0, or
+ * -1 if the image is malformed (the shell then starts over):
+ *
+ *   const ptr = Module._malloc(image.length);
+ *   Module.HEAPU8.set(image, ptr);
+ *   Module._load_snapshot(ptr, image.length);
+ *   Module._free(ptr);
+ */
+EMSCRIPTEN_KEEPALIVE
+int load_snapshot(const char* image, size_t length) {
+    return shell_restore(instance(), image, length);
+}
+
+/** Start journaling changes; call once before the first command when the
+ *  session is to be persisted (see get_journal). */
+EMSCRIPTEN_KEEPALIVE
+void enable_journal(void) {
+    instance();
+    journal_enable();
+}
+
+/**
+ * Journal records of the changes since the last clear_journal, for
+ * persisting a session incrementally after each command:
+ *
+ *   const len = Module._get_journal_length();
+ *   if (len > 0) {
+ *     const ptr = Module._get_journal();
+ *     store.append(Module.HEAPU8.slice(ptr, ptr + len));
+ *     Module._clear_journal();
+ *   }
+ *   if (Module._should_compact_journal() || Module._journal_lost_records()) {
+ *     // replace the stored base and records with a fresh get_snapshot()
+ *   }
+ *
+ * On startup, load_snapshot(base) and then replay_journal(records).
+ */
+EMSCRIPTEN_KEEPALIVE
+const char* get_journal(void) {
+    instance();
+    return journal_data();
+}
+
+/** Length in bytes of the records returned by get_journal. */
+EMSCRIPTEN_KEEPALIVE
+size_t get_journal_length(void) {
+    instance();
+    return journal_length();
+}
+
+/** Drop the records returned by get_journal, once they are stored. */
+EMSCRIPTEN_KEEPALIVE
+void clear_journal(void) {
+    instance();
+    journal_clear();
+}
+
+/** True once the records since the base pass JOURNAL_COMPACT_BYTES, so
+ *  storing a fresh snapshot instead pays off. */
+EMSCRIPTEN_KEEPALIVE
+int should_compact_journal(void) {
+    instance();
+    return journal_wants_compaction();
+}
+
+/** True once a change could not be journaled (memory ran out), so the
+ *  stored records are incomplete and a fresh get_snapshot must replace
+ *  them. Cleared by get_snapshot and load_snapshot. */
+EMSCRIPTEN_KEEPALIVE
+int journal_lost_records(void) {
+    instance();
+    return journal_lost();
+}
+
+/** Apply stored journal records on top of the current filesystem.
+ *  Returns 0, or -1 at the first record that fails. */
+EMSCRIPTEN_KEEPALIVE
+int replay_journal(const char* records, size_t length) {
+    return shell_replay_journal(instance(), records, length);
+}
+
+static out_buf_t g_stats_json = {0};
+
+/**
+ * Per-command call counts, latency histograms, output bytes and heap
+ * allocations since startup, plus the line cache numbers, as one JSON
+ * object for the dashboard:
+ *
+ *   const stats = JSON.parse(Module.ccall('get_stats_json', 'string'));
+ *
+ * The text stays valid until the next call to get_stats_json.
+ */
+EMSCRIPTEN_KEEPALIVE
+const char* get_stats_json(void) {
+    out_buf_reset(&g_stats_json);
+    if (shell_stats_json(instance(), &g_stats_json) != 0) {
+        out_buf_reset(&g_stats_json);
+    }
+    return g_stats_json.data ? g_stats_json.data : "";
 }
 
 int main() {
     // WebAssembly initialization
+    instance();
     custom_printf("Welcome! Type 'help' to see available commands.\n");
     return 0;
 } 
\ No newline at end of file